@@ -3,13 +3,28 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
-#include <iostream>
 #include <memory>
+#include <optional>
+#include <ostream>
 #include <span>
+#include <string_view>
 #include <vector>
 
+#include "batch.h"
+#include "engine.h"
+
 namespace bataille {
 
+std::string_view StrategyName(Strategy strategy) {
+  return strategy == Strategy::kNatural ? "natural" : "optimized";
+}
+
+std::optional<Strategy> ParseStrategy(std::string_view name) {
+  if (name == "natural") return Strategy::kNatural;
+  if (name == "optimized") return Strategy::kOptimized;
+  return std::nullopt;
+}
+
 std::vector<Card> Deck::Make() const {
   std::vector<Card> cards;
   cards.reserve(colors * values);
@@ -24,85 +39,50 @@ std::vector<Card> Deck::Make() const {
 Hand::Hand(const Hand& other)
     : buffer_(std::make_unique<Card[]>(other.buffer_size())),
       buffer_end_(buffer_.get() + other.buffer_size()),
-      start_(buffer_.get() + (other.start_ - other.buffer_.get())),
-      end_(buffer_.get() + (other.end_ - other.buffer_.get())) {
-  memcpy(buffer_.get(), other.buffer_.get(), buffer_size() * sizeof(Card));
-}
-
-bool operator==(const Hand& l, const Hand& r) {
-  assert(l.buffer_size() == r.buffer_size());
-
-  // Otherwise do a full comparison.
-  const Card* lc = l.start_;
-  const Card* rc = r.start_;
-  const Card* const lend = l.end_;
-  const Card* const rend = r.end_;
-  const Card* const lbend = l.buffer_end_;
-  const Card* const rbend = r.buffer_end_;
-  for (; lc != lend && rc != rend;) {
-    if (*lc != *rc) {
-      return false;
-    }
-    ++lc;
-    if (lc == lbend) lc = l.buffer_.get();
-    ++rc;
-    if (rc == rbend) rc = r.buffer_.get();
-  }
-  return lc == lend && rc == rend;
-}
-
-void Hand::PushAll(Card hi, Card lo, std::span<Card> cards, Strategy strategy) {
-  assert(lo < hi);
-  if (strategy == Strategy::kNatural) {
-    Push(hi);
-    Push(lo);
-    // Then in reverse order.
-    if (!cards.empty()) {
-      const Card* const begin = cards.data();
-      const Card* c = begin + cards.size();
-      do {
-        --c;
-        Push(*c);
-        Push(*c);
-      } while (c != begin);
-    }
-  } else {
-    assert(strategy == Strategy::kOptimized);
-    if (cards.empty()) {
-      Push(hi);
-      Push(lo);
-    } else {
-      std::sort(cards.begin(), cards.end(), std::greater<>());
-      const Card* c = cards.data();
-      const Card* const end = c + cards.size();
-      while (c != end && hi < *c) {
-        Push(*c);
-        Push(*c);
-        ++c;
-      }
-      Push(hi);
-      while (c != end && lo < *c) {
-        Push(*c);
-        Push(*c);
-        ++c;
-      }
-      Push(lo);
-      while (c != end && c != end) {
-        Push(*c);
-        Push(*c);
-        ++c;
-      }
-    }
+      start_(buffer_.get()),
+      end_(buffer_.get() + other.size()) {
+  memcpy(start_, other.start_, other.size() * sizeof(Card));
+}
+
+Hand& Hand::operator=(const Hand& other) {
+  assert(buffer_size() == other.buffer_size());
+  const size_t n = other.size();
+  memmove(buffer_.get(), other.start_, n * sizeof(Card));
+  start_ = buffer_.get();
+  end_ = start_ + n;
+  return *this;
+}
+
+void Hand::MoveToStart() {
+  const size_t n = size();
+  memmove(buffer_.get(), start_, n * sizeof(Card));
+  start_ = buffer_.get();
+  end_ = start_ + n;
+}
+
+void Hand::AddTo(StateKey& key) const {
+  key.Add(size());
+  // Cards are added 8 at a time, the last word is padded with zeros.
+  const Card* c = start_;
+  for (; end_ - c >= 8; c += 8) {
+    uint64_t word;
+    memcpy(&word, c, sizeof(word));
+    key.Add(word);
   }
+  uint64_t word = 0;
+  memcpy(&word, c, end_ - c);
+  key.Add(word);
+}
+
+void Hand::AppendTo(std::vector<Card>& cards) const {
+  cards.insert(cards.end(), start_, end_);
 }
 
 std::string Hand::DebugString() const {
   std::string str = "[";
-  for (const Card* c = start_; c != end_;) {
+  for (const Card* c = start_; c != end_; ++c) {
     str.append(std::to_string(*c));
     str.push_back(',');
-    ++c;
-    if (c == buffer_end_) c = buffer_.get();
   }
   str.push_back(']');
   return str;
@@ -127,6 +107,7 @@ bool Game::Step(Strategy strategy) {
     cl = l_.Pop();
     cr = r_.Pop();
   }
+  BATAILLE_COUNT(Ties(num_ties_, strategy));
   if (cr < cl) {
     l_.PushAll(cl, cr, std::span(ties, num_ties_), strategy);
   } else {
@@ -137,12 +118,51 @@ bool Game::Step(Strategy strategy) {
   return l_.empty() || r_.empty();
 }
 
+bool Game::Step(Strategy strategy, unsigned max_rounds, const Game* stop_at,
+                unsigned& num_rounds) {
+  assert(max_rounds > 0);
+  unsigned i = 0;
+  while (true) {
+    ++i;
+    if (i % InstrumentCounters::kHandSizePeriod == 0) [[unlikely]] {
+      BATAILLE_COUNT(left_hand_sizes.Add(l_.size()));
+    }
+    if (l_.Top() == r_.Top()) {
+      if (Step(strategy)) break;
+    } else {
+      // Without ties, both strategies give back the higher card first. The
+      // cards are written to both hands, and only the winner keeps them.
+      const Card cl = l_.Pop();
+      const Card cr = r_.Pop();
+      const bool left_wins = cr < cl;
+      l_.PushPairIf(std::max(cl, cr), std::min(cl, cr), left_wins);
+      r_.PushPairIf(std::max(cl, cr), std::min(cl, cr), !left_wins);
+      if (l_.empty() || r_.empty()) break;
+    }
+    if (i == max_rounds || (stop_at != nullptr && *this == *stop_at)) {
+      num_rounds = i;
+      return false;
+    }
+  }
+  num_rounds = i;
+  return true;
+}
+
 Game::Game(const Game& o)
     : deck_(o.deck_),
       l_(o.l_),
       r_(o.r_),
       ties_(std::make_unique<Card[]>(deck_.num_cards())) {}
 
+Game& Game::operator=(const Game& o) {
+  assert(deck_.colors == o.deck_.colors);
+  assert(deck_.values == o.deck_.values);
+  assert(o.num_ties_ == 0);
+  l_ = o.l_;
+  r_ = o.r_;
+  return *this;
+}
+
 bool operator==(const Game& lhs, const Game& rhs) {
   assert(lhs.num_ties_ == 0);
   assert(rhs.num_ties_ == 0);
@@ -157,33 +177,102 @@ Game::Winner Game::GetWinner() const {
              : (l_.empty() ? Winner::kRight : Winner::kLeft);
 }
 
+bool IsCanonicalDeal(std::span<const Card> cards) {
+  if (cards.size() % 2 != 0) return true;
+  const size_t half = cards.size() / 2;
+  return memcmp(cards.data(), cards.data() + half, half) <= 0;
+}
+
+namespace {
+// Number of deals of `colors` cards of each of `values` values:
+// (C*V)!/(C!)^V
+// log((C*V)!/(C!)^V) = log((C*V)!) - V * log(C!)
+//                    = lgamma(C*V + 1) - V* log(C + 1)
+double NumDeals(int colors, int values) {
+  return std::exp(std::lgamma(colors * values + 1) -
+                  values * std::lgamma(colors + 1));
+}
+
+// Number of games played for `deck`. In the case of an even number of cards,
+// only one deal of each mirrored pair is played (see `IsCanonicalDeal`). Deals
+// whose two halves are equal are their own mirror and are played once: there
+// are (N + S) / 2 games for N deals of which S are self-mirrored. A deal is
+// self-mirrored iff each half holds C/2 cards of each value.
+double NumGames(Deck deck) {
+  const double num_deals = NumDeals(deck.colors, deck.values);
+  if (deck.num_cards() % 2 != 0) return num_deals;
+  const double num_self_mirrored =
+      deck.colors % 2 == 0 ? NumDeals(deck.colors / 2, deck.values) : 0;
+  return (num_deals + num_self_mirrored) / 2;
+}
+}  // namespace
+
 GameArena::Stats::Stats(Deck deck)
-    : longest(deck),
-      shortest_with_cycle(deck),
-      // number of games: (C*V)!/(C!)^V
-      // log((C*V)!/(C!)^V) = log((C*V)!) - V * log(C!)
-      //                    = lgamma(C*V + 1) - V* log(C + 1)
-      num_games(std::exp(std::lgamma(deck.colors * deck.values + 1) -
-                                   deck.values * std::lgamma(deck.colors + 1)) /
-                          // Note: in the case of an even number of cards, we
-                          // divide by two as right and left are symmetric.
-                          (deck.num_cards() % 2 == 0 ? 2 : 1)) {}
+    : longest(deck), shortest_with_cycle(deck), num_games(NumGames(deck)) {}
 
 void GameArena::Stats::Print(std::ostream& os) const {
   os << num_played_with_cycle << " loops found after " << num_played << "/"
      << num_games << "\n";
+  if (cache.lookups > 0) {
+    os << "outcome cache: " << cache.hits << " hits / " << cache.lookups
+       << " lookups\n";
+  }
   if (shortest_with_cycle_len < std::numeric_limits<unsigned>::max()) {
     os << "shortest game with cycle (" << shortest_with_cycle_len
-       << "):\ncartes_joueur1=" << shortest_with_cycle.left().DebugString()
+       << "): mu=" << shortest_with_cycle_mu
+       << " lambda=" << shortest_with_cycle_lambda
+       << "\ncartes_joueur1=" << shortest_with_cycle.left().DebugString()
        << "\ncartes_joueur2=" << shortest_with_cycle.right().DebugString()
        << "\n";
   }
   os << "longest game (" << longest_len
      << "):\ncartes_joueur1=" << longest.left().DebugString()
      << "\ncartes_joueur2=" << longest.right().DebugString() << "\n";
+#ifdef BATAILLE_INSTRUMENT
+  counters.Print(os);
+#endif
 }
 
-GameArena::GameArena(Deck deck) : slow_(deck), fast_(deck), stats_(deck) {}
+void GameArena::Stats::Merge(const Stats& other) {
+  num_played += other.num_played;
+  num_played_with_cycle += other.num_played_with_cycle;
+  cache.lookups += other.cache.lookups;
+  cache.hits += other.cache.hits;
+#ifdef BATAILLE_INSTRUMENT
+  counters.Merge(other.counters);
+#endif
+  if (other.longest_len > longest_len) {
+    longest_len = other.longest_len;
+    longest = other.longest;
+  }
+  if (other.shortest_with_cycle_len < shortest_with_cycle_len) {
+    shortest_with_cycle_len = other.shortest_with_cycle_len;
+    shortest_with_cycle_mu = other.shortest_with_cycle_mu;
+    shortest_with_cycle_lambda = other.shortest_with_cycle_lambda;
+    shortest_with_cycle = other.shortest_with_cycle;
+  }
+}
+
+GameArena::GameArena(Deck deck)
+    : deck_(deck), engine_(MakeEngine(deck)), stats_(deck) {}
+
+GameArena::~GameArena() = default;
+
+void GameArena::SetOutcomeCache(OutcomeCache* cache) {
+  cache_ = cache;
+  engine_->SetCache(cache, &stats_.cache);
+}
+
+void GameArena::SetLexicographicDeals(bool lexicographic) {
+  lexicographic_deals_ = lexicographic;
+  if (batch_) batch_->SetSharePrefixes(lexicographic);
+}
+
+void GameArena::SetEngine(std::unique_ptr<Engine> engine) {
+  engine_ = std::move(engine);
+  engine_->SetCache(cache_, &stats_.cache);
+  custom_engine_ = true;
+}
 
 Game::Result GameArena::PlayImpl(std::span<const Card> cards,
                                  Strategy strategy) {
@@ -193,43 +282,116 @@ Game::Result GameArena::PlayImpl(std::span<const Card> cards,
   if (cards.size() == 1) {
     return {.winner = Game::Winner::kRight, .num_steps = 0};
   }
-  // Cycle detection is done using Stepanov's "collision_point" method.
-  slow_.Deal(cards);
-  fast_.Deal(cards);
-
-  if (fast_.Step(strategy))
-    return {.winner = fast_.GetWinner(), .num_steps = 1};
-
-  unsigned steps = 1;
-  while (slow_ != fast_) {
-    slow_.Step(strategy);
-    if (fast_.Step(strategy))
-      return {.winner = fast_.GetWinner(), .num_steps = 2 * steps};
-    if (fast_.Step(strategy))
-      return {.winner = fast_.GetWinner(), .num_steps = 2 * steps + 1};
-    ++steps;
-  }
-
-  return {.winner = Game::Winner::kCycle, .num_steps = steps};
+  return engine_->Play(cards, strategy);
 }
 
-Game::Result GameArena::Play(std::span<const Card> cards, Strategy strategy) {
-  const Game::Result result = PlayImpl(cards, strategy);
+void GameArena::Record(std::span<const Card> cards,
+                       const Game::Result& result) {
   if (result.winner == Game::Winner::kCycle) {
     ++stats_.num_played_with_cycle;
     if (result.num_steps < stats_.shortest_with_cycle_len) {
       stats_.shortest_with_cycle_len = result.num_steps;
+      stats_.shortest_with_cycle_mu = result.mu;
+      stats_.shortest_with_cycle_lambda = result.lambda;
       stats_.shortest_with_cycle.Deal(cards);
+      if (records_ != nullptr) {
+        records_->Push({.cycle = true,
+                        .num_steps = result.num_steps,
+                        .mu = result.mu,
+                        .lambda = result.lambda,
+                        .cards = {cards.begin(), cards.end()}});
+      }
     }
   } else if (result.num_steps > stats_.longest_len) {
     stats_.longest_len = result.num_steps;
     stats_.longest.Deal(cards);
-    std::cout << "new longest game (" << stats_.longest_len
-              << "): " << stats_.longest.left().DebugString() << " "
-              << stats_.longest.right().DebugString() << "\n";
+    if (records_ != nullptr) {
+      records_->Push({.num_steps = result.num_steps,
+                      .cards = {cards.begin(), cards.end()}});
+    }
   }
   ++stats_.num_played;
+}
+
+Game::Result GameArena::Play(std::span<const Card> cards, Strategy strategy) {
+#ifdef BATAILLE_INSTRUMENT
+  const InstrumentCounters::Scope instrument(&stats_.counters);
+#endif
+  const Game::Result result = PlayImpl(cards, strategy);
+  Record(cards, result);
   return result;
 }
 
+void GameArena::PlayBatch(std::span<const Card> deals,
+                          std::span<Game::Result> results, Strategy strategy) {
+#ifdef BATAILLE_INSTRUMENT
+  const InstrumentCounters::Scope instrument(&stats_.counters);
+#endif
+  const unsigned n = deck_.num_cards();
+  assert(deals.size() == results.size() * n);
+  if (n < 2 || cache_ != nullptr || custom_engine_) {
+    for (size_t i = 0; i < results.size(); ++i) {
+      results[i] = Play(deals.subspan(i * n, n), strategy);
+    }
+    return;
+  }
+  if (!batch_) {
+    batch_ = std::make_unique<BatchEngine>(deck_);
+    batch_->SetSharePrefixes(lexicographic_deals_);
+  }
+
+  // Games longer than the longest one so far are either records or cycles,
+  // and are left to `PlayImpl`.
+  const unsigned max_steps = std::max(stats_.longest_len, 8 * n);
+  unresolved_.clear();
+  batch_->Play(deals, results, strategy, max_steps, unresolved_);
+  for (const size_t i : unresolved_) {
+    results[i] = PlayImpl(deals.subspan(i * n, n), strategy);
+  }
+  for (size_t i = 0; i < results.size(); ++i) {
+    Record(deals.subspan(i * n, n), results[i]);
+  }
+}
+
+void GameArena::PlayBatchBoth(std::span<const Card> deals,
+                              std::span<Game::Result> natural_results,
+                              std::span<Game::Result> optimized_results,
+                              GameArena& optimized) {
+  const unsigned n = deck_.num_cards();
+  assert(optimized.deck_.num_cards() == n);
+  assert(deals.size() == natural_results.size() * n);
+  assert(optimized_results.size() == natural_results.size());
+  if (n < 2 || cache_ != nullptr || optimized.cache_ != nullptr ||
+      custom_engine_ || optimized.custom_engine_) {
+    PlayBatch(deals, natural_results, Strategy::kNatural);
+    optimized.PlayBatch(deals, optimized_results, Strategy::kOptimized);
+    return;
+  }
+#ifdef BATAILLE_INSTRUMENT
+  const InstrumentCounters::Scope instrument(&stats_.counters);
+#endif
+  if (!batch_) {
+    batch_ = std::make_unique<BatchEngine>(deck_);
+    batch_->SetSharePrefixes(lexicographic_deals_);
+  }
+
+  const unsigned max_steps = std::max(
+      {stats_.longest_len, optimized.stats_.longest_len, 8 * n});
+  unresolved_.clear();
+  optimized.unresolved_.clear();
+  batch_->PlayBoth(deals, natural_results, optimized_results, max_steps,
+                   unresolved_, optimized.unresolved_);
+  for (const size_t i : unresolved_) {
+    natural_results[i] = PlayImpl(deals.subspan(i * n, n), Strategy::kNatural);
+  }
+  for (const size_t i : optimized.unresolved_) {
+    optimized_results[i] =
+        optimized.PlayImpl(deals.subspan(i * n, n), Strategy::kOptimized);
+  }
+  for (size_t i = 0; i < natural_results.size(); ++i) {
+    Record(deals.subspan(i * n, n), natural_results[i]);
+    optimized.Record(deals.subspan(i * n, n), optimized_results[i]);
+  }
+}
+
 }  // namespace bataille
@@ -1,16 +1,23 @@
 
 #ifndef BATAILLE_H
-#define BATAILLE
+#define BATAILLE_H
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "instrument.h"
+#include "mpsc_queue.h"
+
 namespace bataille {
 
 // Card values are in 1..255.
@@ -36,17 +43,101 @@ enum class Strategy {
   kOptimized,  // Optimized strategy.
 };
 
-// A hand is a circular array.
+// Returns the name of the strategy: "natural" or "optimized".
+std::string_view StrategyName(Strategy strategy);
+// Returns the strategy named `name`, or std::nullopt if there is none.
+std::optional<Strategy> ParseStrategy(std::string_view name);
+
+// A 128-bit hash of a game state, built by adding the cards of both hands.
+// Keys are computed from scratch when needed: engines only probe the outcome
+// cache a few times per game, so updating a rolling fingerprint on every card
+// moved costs more than it saves (games were 15-30% slower).
+class StateKey {
+ public:
+  void Add(uint64_t value) {
+    h1_ = (h1_ ^ value) * 0x9e3779b97f4a7c15ull;
+    h1_ ^= h1_ >> 32;
+    h2_ = (h2_ + value) * 0xc2b2ae3d27d4eb4full;
+    h2_ ^= h2_ >> 29;
+  }
+
+  uint64_t h1() const { return h1_; }
+  uint64_t h2() const { return h2_; }
+
+  friend bool operator==(const StateKey&, const StateKey&) = default;
+
+ private:
+  uint64_t h1_ = 0x243f6a8885a308d3ull;
+  uint64_t h2_ = 0x13198a2e03707344ull;
+};
+
+// Gives the cards of a round to its winner: `hi` and `lo` are the cards of
+// the deciding battle, and `ties` holds one card per tied pair (in the order
+// they were played). Calls `push(card)` for each card, in the order given by
+// `strategy`.
+template <typename PushFn>
+void PushRoundCards(Card hi, Card lo, std::span<Card> ties, Strategy strategy,
+                    PushFn push) {
+  assert(lo < hi);
+  if (strategy == Strategy::kNatural) {
+    push(hi);
+    push(lo);
+    // Then in reverse order.
+    if (!ties.empty()) {
+      const Card* const begin = ties.data();
+      const Card* c = begin + ties.size();
+      do {
+        --c;
+        push(*c);
+        push(*c);
+      } while (c != begin);
+    }
+  } else {
+    assert(strategy == Strategy::kOptimized);
+    if (ties.empty()) {
+      push(hi);
+      push(lo);
+    } else {
+      std::sort(ties.begin(), ties.end(), std::greater<>());
+      const Card* c = ties.data();
+      const Card* const end = c + ties.size();
+      while (c != end && hi < *c) {
+        push(*c);
+        push(*c);
+        ++c;
+      }
+      push(hi);
+      while (c != end && lo < *c) {
+        push(*c);
+        push(*c);
+        ++c;
+      }
+      push(lo);
+      while (c != end) {
+        push(*c);
+        push(*c);
+        ++c;
+      }
+    }
+  }
+}
+
+// A hand is a window in an array: cards are popped at the front of the window
+// and pushed at its back, so neither wraps around. When the window reaches the
+// end of the array, it moves back to the start. The array is several times
+// larger than the hand, so this happens once every few rounds.
 class Hand {
  public:
   explicit Hand(unsigned max_cards)
-      : buffer_(std::make_unique<Card[]>(max_cards + 1)),
-        buffer_end_(buffer_.get() + max_cards + 1),
+      : buffer_(std::make_unique<Card[]>(kWindows * max_cards + 2)),
+        buffer_end_(buffer_.get() + kWindows * max_cards + 2),
         start_(buffer_.get()),
         end_(buffer_.get()) {}
 
   Hand(const Hand& hand);
   Hand(Hand&&) = default;
+  // Precondition: both hands have the same capacity.
+  Hand& operator=(const Hand& hand);
 
   void Assign(const Card* cards, int n) {
     start_ = buffer_.get();
@@ -55,33 +146,70 @@ class Hand {
     memcpy(start_, cards, n * sizeof(Card));
   }
 
-  friend bool operator==(const Hand& l, const Hand& r);
+  friend bool operator==(const Hand& l, const Hand& r) {
+    if (l.size() != r.size()) return false;
+    // Hands usually differ early, this is faster than calling `memcmp`.
+    for (size_t i = 0; i < l.size(); ++i) {
+      if (l.start_[i] != r.start_[i]) return false;
+    }
+    return true;
+  }
 
   bool empty() const { return start_ == end_; }
+  size_t size() const { return end_ - start_; }
+
+  // Adds the size and the cards of the hand to `key`.
+  void AddTo(StateKey& key) const;
+
+  // Appends the cards of the hand to `cards`, from top to bottom.
+  void AppendTo(std::vector<Card>& cards) const;
 
   std::string DebugString() const;
 
+  Card Top() const {
+    assert(!empty());
+    return *start_;
+  }
+
   // Remove the top card of the hand.
   Card Pop() {
     assert(!empty());
-    const Card card = *start_;
-    ++start_;
-    if (start_ == buffer_end_) start_ = buffer_.get();
-    return card;
+    return *start_++;
   }
 
   // Add a card at the bottom.
   void Push(Card card) {
-    // Add card.
-    *end_ = card;
-    ++end_;
-    if (end_ == buffer_end_) end_ = buffer_.get();
+    Reserve(1);
+    *end_++ = card;
+  }
+
+  // Writes `hi` then `lo` past the bottom of the hand, and adds them to the
+  // hand if `keep`.
+  void PushPairIf(Card hi, Card lo, bool keep) {
+    Reserve(2);
+    end_[0] = hi;
+    end_[1] = lo;
+    end_ += 2 * keep;
   }
 
   // Add a bunch of cards at the bottom.
-  void PushAll(Card hi, Card lo, std::span<Card> cards, Strategy strategy);
+  void PushAll(Card hi, Card lo, std::span<Card> cards, Strategy strategy) {
+    Reserve(2 * cards.size() + 2);
+    PushRoundCards(hi, lo, cards, strategy,
+                   [this](Card card) { *end_++ = card; });
+  }
 
  private:
+  // The size of the array, in hands.
+  static constexpr unsigned kWindows = 4;
+
+  // Makes room for `n` cards past the bottom of the hand, by moving the
+  // window to the start of the array if needed.
+  void Reserve(size_t n) {
+    if (static_cast<size_t>(buffer_end_ - end_) < n) MoveToStart();
+  }
+  void MoveToStart();
+
   size_t buffer_size() const { return buffer_end_ - buffer_.get(); }
   const std::unique_ptr<Card[]> buffer_;
   const Card* const buffer_end_;
@@ -99,10 +227,15 @@ class Game {
 
   // Splits the deck is evenly between left and right: the first half goes to
   // left player. If odd, the first player gets one card less.
-  void Deal(std::span<const Card> cards) {
+  void Deal(std::span<const Card> cards) { Deal(cards, cards.size() / 2); }
+
+  // Gives the first `num_left` cards to the left player, and the others to the
+  // right player.
+  void Deal(std::span<const Card> cards, size_t num_left) {
     assert(cards.size() == deck_.num_cards());
-    l_.Assign(cards.data(), cards.size() / 2);
-    r_.Assign(cards.data() + cards.size() / 2, cards.size() - cards.size() / 2);
+    assert(num_left <= cards.size());
+    l_.Assign(cards.data(), num_left);
+    r_.Assign(cards.data() + num_left, cards.size() - num_left);
   }
 
   const Hand& left() const { return l_; }
@@ -110,6 +243,23 @@ class Game {
 
   friend bool operator==(const Game& lhs, const Game& rhs);
 
+  // Returns the cards of the left then right hands. For a game that was just
+  // dealt, this is the deal.
+  std::vector<Card> Cards() const {
+    std::vector<Card> cards;
+    l_.AppendTo(cards);
+    r_.AppendTo(cards);
+    return cards;
+  }
+
+  // Returns a hash of the state of the game.
+  StateKey Key() const {
+    StateKey key;
+    l_.AddTo(key);
+    r_.AddTo(key);
+    return key;
+  }
+
   enum class Winner {
     kLeft,
     kRight,
@@ -118,17 +268,36 @@ class Game {
   };
   struct Result {
     Winner winner;
+    // The number of rounds until the end of the game. For cycles, this is the
+    // number of rounds at which Stepanov's collision-point method detects the
+    // cycle, i.e. the smallest multiple of `lambda` that is larger than `mu`.
+    // This is what earlier versions reported, and what records compare.
     unsigned num_steps;
+    // For cycles only: the number of rounds before entering the cycle, and the
+    // period of the cycle.
+    unsigned mu = 0;
+    unsigned lambda = 0;
   };
 
   // Does one round (incl. resolving ties) and returns true if any side is
   // empty.
   bool Step(Strategy strategy);
 
+  // Same as above, but plays up to `max_rounds` rounds (at least one), until
+  // the end of the game or until the game is in state `stop_at` (if not
+  // null). Sets `num_rounds` to the number of rounds played. Rounds without
+  // ties do not branch on their winner. Ties are looked for one round at a
+  // time: engines call this with runs of 2-3 rounds on average, too short for
+  // a vectorized scan of the top cards to pay off (it was 10-25% slower).
+  bool Step(Strategy strategy, unsigned max_rounds, const Game* stop_at,
+            unsigned& num_rounds);
+
   // Given that at least one of the hands is empty, returns the winner.
   Winner GetWinner() const;
 
   Game(const Game& o);
+  // Precondition: both games are for the same deck.
+  Game& operator=(const Game& o);
   Deck deck() const { return deck_; }
 
  private:
@@ -142,43 +311,131 @@ class Game {
   unsigned num_ties_ = 0;
 };
 
+// When the number of cards is even, swapping the left and right hands of a
+// deal gives a mirrored game, with the same length and cycles, and the winner
+// swapped. Returns true if `cards` is the canonical deal of its pair, i.e. if
+// the left hand is not larger (lexicographically) than the right hand.
+// Deals with an odd number of cards have no mirror and are all canonical.
+bool IsCanonicalDeal(std::span<const Card> cards);
+
+class BatchEngine;
+class Engine;
+class OutcomeCache;
+
 // A class that plays a bunch of games and computes stats.
 // This reuses games in between calls to `Play` to avoid allocations.
 class GameArena {
  public:
   GameArena(Deck deck);
+  ~GameArena();
   // Runs the game until the end or until we find a cycle.
   // Left player gets the first half, right player gets the second half. If odd,
   // the first player gets one card less.
   Game::Result Play(std::span<const Card> cards, Strategy strategy);
 
+  // Plays `results.size()` games, whose deals are stored one after the other
+  // in `deals`. This gives the same results and stats as calling `Play` on
+  // each deal in order, but plays games in lockstep (see `BatchEngine`), which
+  // is faster for short and medium games.
+  void PlayBatch(std::span<const Card> deals, std::span<Game::Result> results,
+                 Strategy strategy);
+
+  // Like `PlayBatch` with both strategies: this arena plays and records the
+  // natural games, `optimized` the optimized games. Games are played once
+  // until their first tie, which is faster than two calls to `PlayBatch` (see
+  // `BatchEngine::PlayBoth`).
+  void PlayBatchBoth(std::span<const Card> deals,
+                     std::span<Game::Result> natural_results,
+                     std::span<Game::Result> optimized_results,
+                     GameArena& optimized);
+
+  // Makes games look up and remember intermediate states in `cache`, which
+  // can be shared by the arenas of all threads exploring the same deck. When
+  // a state is found, the game stops there. Batches are then played one game
+  // at a time.
+  void SetOutcomeCache(OutcomeCache* cache);
+
+  // Tells batches that their deals are permutations in lexicographic order,
+  // following the deals of the previous batch, as in exhaustive explorations.
+  // Consecutive deals then often share their first cards, and their games
+  // start from the rounds already played for the previous deal (see
+  // `PrefixSnapshot`). Other deals are dealt and played from the start.
+  void SetLexicographicDeals(bool lexicographic);
+
+  // Replaces the engine that plays games, for example with one that looks up
+  // precomputed results (see `StateGraph`). Batches are then played one game
+  // at a time.
+  void SetEngine(std::unique_ptr<Engine> engine);
+
+  // A new record of an arena: its longest game, or its shortest game with a
+  // cycle.
+  struct RecordEvent {
+    bool cycle = false;
+    unsigned num_steps = 0;
+    unsigned mu = 0;
+    unsigned lambda = 0;
+    std::vector<Card> cards;
+  };
+  using RecordQueue = MpscQueue<RecordEvent>;
+
+  // Makes the arena push its new records to `queue`, which can be shared by
+  // the arenas of all threads, so that they are reported by another thread
+  // without stopping the games.
+  void SetRecordQueue(RecordQueue* queue) { records_ = queue; }
+
   struct Stats {
     Stats(Deck deck);
 
     void Print(std::ostream& os) const;
 
+    // Accumulates the stats of `other`, which must be for the same deck.
+    void Merge(const Stats& other);
+
     // A snapshot of the length best games so far. Only for comparison, do not
     // rely on the type.
     auto snapshot() const {
       return std::make_pair(longest_len, shortest_with_cycle_len);
     }
 
+    // Lookups in the outcome cache (if any).
+    struct CacheCounters {
+      uint64_t lookups = 0;
+      uint64_t hits = 0;
+    };
+
     uint64_t num_played = 0;
     uint64_t num_played_with_cycle = 0;
     unsigned longest_len = 0;
     Game longest;
     unsigned shortest_with_cycle_len = std::numeric_limits<unsigned>::max();
+    unsigned shortest_with_cycle_mu = 0;
+    unsigned shortest_with_cycle_lambda = 0;
     Game shortest_with_cycle;
+    CacheCounters cache;
+#ifdef BATAILLE_INSTRUMENT
+    InstrumentCounters counters;
+#endif
     const double num_games;
   };
   const Stats& stats() const { return stats_; }
 
  private:
   Game::Result PlayImpl(std::span<const Card> cards, Strategy strategy);
+  // Updates the stats with the result of a game.
+  void Record(std::span<const Card> cards, const Game::Result& result);
 
-  Game slow_;
-  Game fast_;
+  const Deck deck_;
+  std::unique_ptr<Engine> engine_;
   Stats stats_;
+  // Created on first use.
+  std::unique_ptr<BatchEngine> batch_;
+  // Set with `SetLexicographicDeals`.
+  bool lexicographic_deals_ = false;
+  OutcomeCache* cache_ = nullptr;
+  // Whether `engine_` was set with `SetEngine`.
+  bool custom_engine_ = false;
+  RecordQueue* records_ = nullptr;
+  std::vector<size_t> unresolved_;
 };
 
 }  // namespace bataille
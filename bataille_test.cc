@@ -2,6 +2,12 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
 namespace bataille {
 namespace {
 
@@ -16,7 +22,11 @@ TEST(StatsTest, NumGames) {
   EXPECT_NEAR(GameArena::Stats({.colors = 1, .values = 5}).num_games, 120,
               0.01);
   EXPECT_NEAR(GameArena::Stats({.colors = 4, .values = 5}).num_games,
-              152770117500ull, 0.01);
+              152770174200ull, 0.01);
+  // 1122 2112 2211 1221 1212 2121: the last two are their own mirror.
+  EXPECT_NEAR(GameArena::Stats({.colors = 2, .values = 2}).num_games, 4, 0.01);
+  EXPECT_NEAR(GameArena::Stats({.colors = 1, .values = 4}).num_games, 12,
+              0.01);
 }
 
 TEST(DeckTest, Make) {
@@ -31,6 +41,48 @@ TEST(DeckTest, Make) {
   EXPECT_EQ(num_permutations, 6 * 5 * 4 * 3 * 2 / 8);
 }
 
+TEST(DeckTest, CanonicalDeals) {
+  EXPECT_TRUE(IsCanonicalDeal(Cards({1, 2}, {2, 1})));
+  EXPECT_TRUE(IsCanonicalDeal(Cards({1, 2}, {1, 2})));
+  EXPECT_FALSE(IsCanonicalDeal(Cards({2, 1}, {1, 2})));
+  EXPECT_TRUE(IsCanonicalDeal(Cards({3, 1}, {1, 2, 2})));
+
+  // Mirrored games have the same length and cycles, and swapped winners.
+  for (const Deck deck : {Deck{.colors = 2, .values = 4}, Deck::Seq(8)}) {
+    GameArena arena(deck);
+    std::vector<Card> cards = deck.Make();
+    const size_t half = cards.size() / 2;
+    uint64_t num_canonical = 0;
+    uint64_t num_self_mirrored = 0;
+    uint64_t num_deals = 0;
+    do {
+      ++num_deals;
+      if (!IsCanonicalDeal(cards)) continue;
+      ++num_canonical;
+      std::vector<Card> mirror(cards.begin() + half, cards.end());
+      mirror.insert(mirror.end(), cards.begin(), cards.begin() + half);
+      if (mirror == cards) ++num_self_mirrored;
+      const Game::Result result = arena.Play(cards, Strategy::kNatural);
+      const Game::Result mirrored = arena.Play(mirror, Strategy::kNatural);
+      EXPECT_EQ(mirrored.num_steps, result.num_steps);
+      EXPECT_EQ(mirrored.mu, result.mu);
+      EXPECT_EQ(mirrored.lambda, result.lambda);
+      switch (result.winner) {
+        case Game::Winner::kLeft:
+          EXPECT_EQ(mirrored.winner, Game::Winner::kRight);
+          break;
+        case Game::Winner::kRight:
+          EXPECT_EQ(mirrored.winner, Game::Winner::kLeft);
+          break;
+        default:
+          EXPECT_EQ(mirrored.winner, result.winner);
+      }
+    } while (std::next_permutation(cards.begin(), cards.end()));
+    EXPECT_EQ(2 * num_canonical, num_deals + num_self_mirrored);
+    EXPECT_NEAR(GameArena::Stats(deck).num_games, num_canonical, 0.01);
+  }
+}
+
 TEST(Hand, Basic) {
   Hand hand(3);
   EXPECT_TRUE(hand.empty());
@@ -90,6 +142,86 @@ TEST(Hand, CopyEquality) {
   EXPECT_TRUE(hand == copy);
 }
 
+TEST(Hand, MovesWindow) {
+  Hand hand(4);
+  hand.Push(1);
+  hand.Push(2);
+  Hand other(4);
+  other.Push(1);
+  other.Push(2);
+  // Many more cards than the array holds go through the hand.
+  for (Card c = 3; c < 100; ++c) {
+    hand.Push(c);
+    EXPECT_EQ(hand.Pop(), c - 2);
+  }
+  EXPECT_EQ(hand.DebugString(), "[98,99,]");
+  EXPECT_FALSE(hand == other);
+  other = hand;
+  EXPECT_TRUE(hand == other);
+  const Hand& self = hand;
+  hand = self;
+  EXPECT_EQ(hand.DebugString(), "[98,99,]");
+  hand.PushPairIf(1, 2, false);
+  hand.PushPairIf(3, 4, true);
+  EXPECT_EQ(hand.DebugString(), "[98,99,3,4,]");
+}
+
+TEST(Hand, AddTo) {
+  const auto key_of = [](const Hand& hand) {
+    StateKey key;
+    hand.AddTo(key);
+    return key;
+  };
+  Hand hand(16);
+  Hand other(16);
+  EXPECT_EQ(key_of(hand), key_of(other));
+  // Many more cards than the array holds go through the hand.
+  for (Card c = 1; c < 100; ++c) {
+    hand.Push(c);
+    if (hand.size() > 11) hand.Pop();
+    std::vector<Card> cards;
+    hand.AppendTo(cards);
+    other.Assign(cards.data(), cards.size());
+    EXPECT_EQ(key_of(hand), key_of(other)) << hand.DebugString();
+  }
+  const StateKey key = key_of(hand);
+  hand.Pop();
+  EXPECT_FALSE(key_of(hand) == key);
+  hand.Push(1);
+  EXPECT_FALSE(key_of(hand) == key);
+}
+
+TEST(GameTest, StepManyRounds) {
+  const Deck deck = Deck::Standard54();
+  std::mt19937 gen(42);
+  std::vector<Card> cards = deck.Make();
+  for (const Strategy strategy : {Strategy::kNatural, Strategy::kOptimized}) {
+    for (int i = 0; i < 100; ++i) {
+      std::shuffle(cards.begin(), cards.end(), gen);
+      Game game(deck);
+      Game expected(deck);
+      game.Deal(cards);
+      expected.Deal(cards);
+      for (unsigned max_rounds = 1; max_rounds < 5000; ++max_rounds) {
+        unsigned num_rounds = 0;
+        const bool over =
+            game.Step(strategy, max_rounds % 40 + 1, nullptr, num_rounds);
+        ASSERT_GE(num_rounds, 1);
+        ASSERT_LE(num_rounds, max_rounds % 40 + 1);
+        bool expected_over = false;
+        for (unsigned round = 0; round < num_rounds; ++round) {
+          ASSERT_FALSE(expected_over);
+          expected_over = expected.Step(strategy);
+        }
+        ASSERT_EQ(over, expected_over);
+        ASSERT_EQ(game.left().DebugString(), expected.left().DebugString());
+        ASSERT_EQ(game.right().DebugString(), expected.right().DebugString());
+        if (over) break;
+      }
+    }
+  }
+}
+
 TEST(Hand, SimpleSeq2a) {
   GameArena arena(Deck::Seq(2));
   const auto result = arena.Play(Cards({1}, {2}), Strategy::kNatural);
@@ -134,6 +266,8 @@ TEST(Hand, LoopC1V5) {
   const auto result = arena.Play(Cards({5, 3}, {2, 4, 1}), Strategy::kNatural);
   EXPECT_EQ(result.winner, Game::Winner::kCycle);
   EXPECT_EQ(result.num_steps, 6);
+  EXPECT_EQ(result.mu, 0);
+  EXPECT_EQ(result.lambda, 6);
 }
 
 TEST(Hand, LoopC1V7) {
@@ -142,6 +276,8 @@ TEST(Hand, LoopC1V7) {
       arena.Play(Cards({1, 7, 4}, {5, 3, 6, 2}), Strategy::kNatural);
   EXPECT_EQ(result.winner, Game::Winner::kCycle);
   EXPECT_EQ(result.num_steps, 8);
+  EXPECT_EQ(result.mu, 0);
+  EXPECT_EQ(result.lambda, 8);
 }
 
 TEST(Hand, LoopC1V9) {
@@ -150,6 +286,8 @@ TEST(Hand, LoopC1V9) {
       arena.Play(Cards({9, 5, 8, 1}, {3, 7, 2, 6, 1}), Strategy::kNatural);
   EXPECT_EQ(result.winner, Game::Winner::kCycle);
   EXPECT_EQ(result.num_steps, 20);
+  EXPECT_EQ(result.mu, 0);
+  EXPECT_EQ(result.lambda, 20);
 }
 
 TEST(Hand, LoopC1V10) {
@@ -158,6 +296,18 @@ TEST(Hand, LoopC1V10) {
       arena.Play(Cards({8, 6, 3, 10, 5}, {2, 9, 7, 4, 1}), Strategy::kNatural);
   EXPECT_EQ(result.winner, Game::Winner::kCycle);
   EXPECT_EQ(result.num_steps, 60);
+  EXPECT_EQ(result.mu, 0);
+  EXPECT_EQ(result.lambda, 60);
+}
+
+TEST(Hand, LoopWithTailC4V3) {
+  GameArena arena({.colors = 4, .values = 3});
+  const auto result = arena.Play(Cards({1, 1, 1, 1, 2, 3}, {2, 3, 3, 3, 2, 2}),
+                                 Strategy::kNatural);
+  EXPECT_EQ(result.winner, Game::Winner::kCycle);
+  EXPECT_EQ(result.num_steps, 19);
+  EXPECT_EQ(result.mu, 16);
+  EXPECT_EQ(result.lambda, 19);
 }
 
 TEST(Hand, NoLoopC1V16) {
@@ -185,6 +335,160 @@ TEST(Hand, OptimizedC4V3) {
   EXPECT_EQ(result.num_steps, 34);
 }
 
+// Returns (mu, lambda) by remembering all states of the game.
+std::pair<unsigned, unsigned> NaiveCycle(Deck deck, std::span<const Card> cards,
+                                         Strategy strategy) {
+  Game game(deck);
+  game.Deal(cards);
+  std::map<std::string, unsigned> seen;
+  for (unsigned step = 0;; ++step) {
+    const auto [it, inserted] = seen.emplace(
+        game.left().DebugString() + game.right().DebugString(), step);
+    if (!inserted) return {it->second, step - it->second};
+    if (game.Step(strategy)) return {0, 0};
+  }
+}
+
+TEST(GameArenaTest, CycleLengths) {
+  for (const Deck deck : {Deck::Seq(7), Deck::Seq(9)}) {
+    GameArena arena(deck);
+    std::vector<Card> cards = deck.Make();
+    do {
+      const auto result = arena.Play(cards, Strategy::kNatural);
+      const auto [mu, lambda] = NaiveCycle(deck, cards, Strategy::kNatural);
+      ASSERT_EQ(result.mu, mu);
+      ASSERT_EQ(result.lambda, lambda);
+      ASSERT_EQ(result.winner == Game::Winner::kCycle, lambda > 0);
+    } while (std::next_permutation(cards.begin(), cards.end()));
+  }
+}
+
+void ExpectResultsEq(const std::vector<Game::Result>& results,
+                     const std::vector<Game::Result>& expected) {
+  ASSERT_EQ(results.size(), expected.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].winner, expected[i].winner) << i;
+    EXPECT_EQ(results[i].num_steps, expected[i].num_steps) << i;
+    EXPECT_EQ(results[i].mu, expected[i].mu) << i;
+    EXPECT_EQ(results[i].lambda, expected[i].lambda) << i;
+  }
+}
+
+void ExpectStatsEq(const GameArena::Stats& stats,
+                   const GameArena::Stats& expected) {
+  EXPECT_EQ(stats.num_played, expected.num_played);
+  EXPECT_EQ(stats.num_played_with_cycle, expected.num_played_with_cycle);
+  EXPECT_EQ(stats.snapshot(), expected.snapshot());
+  EXPECT_EQ(stats.longest, expected.longest);
+}
+
+// Plays `deals` one by one and in a batch, and checks that results and stats
+// are the same. Batches are played with and without shared prefixes, which
+// give the same results whatever the order of the deals.
+void ExpectBatchMatchesPlay(Deck deck, const std::vector<Card>& deals,
+                            Strategy strategy) {
+  const unsigned n = deck.num_cards();
+  const size_t num_deals = deals.size() / n;
+  GameArena arena(deck);
+  std::vector<Game::Result> expected;
+  for (size_t i = 0; i < num_deals; ++i) {
+    expected.push_back(
+        arena.Play(std::span(deals).subspan(i * n, n), strategy));
+  }
+
+  for (const bool lexicographic : {false, true}) {
+    GameArena batch_arena(deck);
+    batch_arena.SetLexicographicDeals(lexicographic);
+    std::vector<Game::Result> results(num_deals);
+    batch_arena.PlayBatch(deals, results, strategy);
+    ExpectResultsEq(results, expected);
+    ExpectStatsEq(batch_arena.stats(), arena.stats());
+  }
+}
+
+// Plays `deals` with both strategies in one pass, in two batches.
+void ExpectBatchBothMatchesPlay(Deck deck, const std::vector<Card>& deals) {
+  const unsigned n = deck.num_cards();
+  const size_t num_deals = deals.size() / n;
+  GameArena natural(deck), optimized(deck);
+  std::vector<Game::Result> expected_natural, expected_optimized;
+  for (size_t i = 0; i < num_deals; ++i) {
+    const std::span<const Card> cards = std::span(deals).subspan(i * n, n);
+    expected_natural.push_back(natural.Play(cards, Strategy::kNatural));
+    expected_optimized.push_back(optimized.Play(cards, Strategy::kOptimized));
+  }
+
+  for (const bool lexicographic : {false, true}) {
+    GameArena both_natural(deck), both_optimized(deck);
+    both_natural.SetLexicographicDeals(lexicographic);
+    both_optimized.SetLexicographicDeals(lexicographic);
+    std::vector<Game::Result> natural_results(num_deals);
+    std::vector<Game::Result> optimized_results(num_deals);
+    const size_t half = num_deals / 2;
+    both_natural.PlayBatchBoth(std::span(deals).first(half * n),
+                               std::span(natural_results).first(half),
+                               std::span(optimized_results).first(half),
+                               both_optimized);
+    both_natural.PlayBatchBoth(std::span(deals).subspan(half * n),
+                               std::span(natural_results).subspan(half),
+                               std::span(optimized_results).subspan(half),
+                               both_optimized);
+    ExpectResultsEq(natural_results, expected_natural);
+    ExpectResultsEq(optimized_results, expected_optimized);
+    ExpectStatsEq(both_natural.stats(), natural.stats());
+    ExpectStatsEq(both_optimized.stats(), optimized.stats());
+  }
+}
+
+std::vector<Card> AllDeals(Deck deck) {
+  std::vector<Card> cards = deck.Make();
+  std::vector<Card> deals;
+  do {
+    deals.insert(deals.end(), cards.begin(), cards.end());
+  } while (std::next_permutation(cards.begin(), cards.end()));
+  return deals;
+}
+
+std::vector<Card> RandomDeals(Deck deck, int num_deals) {
+  std::mt19937 gen(42);
+  std::vector<Card> cards = deck.Make();
+  std::vector<Card> deals;
+  for (int i = 0; i < num_deals; ++i) {
+    std::shuffle(cards.begin(), cards.end(), gen);
+    deals.insert(deals.end(), cards.begin(), cards.end());
+  }
+  return deals;
+}
+
+TEST(GameArenaTest, PlayBatchMatchesPlay) {
+  for (const Strategy strategy : {Strategy::kNatural, Strategy::kOptimized}) {
+    ExpectBatchMatchesPlay(Deck::Seq(7), AllDeals(Deck::Seq(7)), strategy);
+    ExpectBatchMatchesPlay({.colors = 4, .values = 3},
+                           AllDeals({.colors = 4, .values = 3}), strategy);
+    ExpectBatchMatchesPlay(Deck::Standard32(),
+                           RandomDeals(Deck::Standard32(), 1000), strategy);
+    ExpectBatchMatchesPlay(Deck::Standard54(),
+                           RandomDeals(Deck::Standard54(), 100), strategy);
+  }
+}
+
+TEST(GameArenaTest, PlayBatchBothMatchesPlay) {
+  ExpectBatchBothMatchesPlay(Deck::Seq(7), AllDeals(Deck::Seq(7)));
+  ExpectBatchBothMatchesPlay({.colors = 4, .values = 3},
+                             AllDeals({.colors = 4, .values = 3}));
+  ExpectBatchBothMatchesPlay(Deck::Standard32(),
+                             RandomDeals(Deck::Standard32(), 1000));
+  ExpectBatchBothMatchesPlay(Deck::Standard54(),
+                             RandomDeals(Deck::Standard54(), 100));
+  ExpectBatchBothMatchesPlay(Deck::Seq(2), {1, 2, 2, 1});
+}
+
+TEST(GameArenaTest, PlayBatchTinyDecks) {
+  ExpectBatchMatchesPlay(Deck::Seq(1), {1}, Strategy::kNatural);
+  ExpectBatchMatchesPlay(Deck::Seq(2), {1, 2, 2, 1}, Strategy::kNatural);
+  ExpectBatchMatchesPlay({.colors = 2, .values = 1}, {1, 1},
+                         Strategy::kNatural);
+}
 
 }  // namespace
 }  // namespace bataille
\ No newline at end of file
@@ -0,0 +1,392 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "instrument.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace bataille {
+namespace {
+
+// Gathers read 4 bytes at a time, so the rings are padded.
+constexpr unsigned kGatherPadding = 3;
+
+uint32_t RingCapacity(Deck deck) { return std::bit_ceil(deck.num_cards() + 2); }
+
+bool HasAvx2() {
+#if defined(__x86_64__)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+BatchEngine::BatchEngine(Deck deck)
+    : deck_(deck),
+      capacity_(RingCapacity(deck)),
+      mask_(capacity_ - 1),
+      has_avx2_(HasAvx2()),
+      left_(std::make_unique<Card[]>(kNumLanes * capacity_ + kGatherPadding)),
+      right_(std::make_unique<Card[]>(kNumLanes * capacity_ + kGatherPadding)),
+      ties_(std::make_unique<Card[]>(deck.num_cards())),
+      prefix_(deck, capacity_) {
+  left_head_.fill(0);
+  left_len_.fill(0);
+  right_head_.fill(0);
+  right_len_.fill(0);
+  steps_.fill(0);
+  deal_.fill(0);
+}
+
+uint32_t BatchEngine::Round() {
+  uint32_t ties = 0;
+  for (unsigned k = 0; k < kNumLanes; ++k) {
+    Card* const l = left(k);
+    Card* const r = right(k);
+    const Card cl = l[left_head_[k] & mask_];
+    const Card cr = r[right_head_[k] & mask_];
+    const Card hi = std::max(cl, cr);
+    const Card lo = std::min(cl, cr);
+    l[(left_head_[k] + left_len_[k]) & mask_] = hi;
+    l[(left_head_[k] + left_len_[k] + 1) & mask_] = lo;
+    r[(right_head_[k] + right_len_[k]) & mask_] = hi;
+    r[(right_head_[k] + right_len_[k] + 1) & mask_] = lo;
+    const uint32_t tie = cl == cr;
+    const uint32_t play = ((active_ >> k) & 1) & (tie ^ 1);
+    const uint32_t left_wins = cr < cl;
+    left_head_[k] += play;
+    right_head_[k] += play;
+    left_len_[k] += play * (2 * left_wins) - play;
+    right_len_[k] += play * (2 * (left_wins ^ 1)) - play;
+    steps_[k] += play;
+    ties |= tie << k;
+  }
+  return ties & active_;
+}
+
+#if defined(__x86_64__)
+[[gnu::target("avx2")]] uint32_t BatchEngine::RoundAvx2() {
+  static_assert(kNumLanes % 8 == 0);
+  const __m256i mask = _mm256_set1_epi32(mask_);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m256i lane_offsets = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(capacity_));
+  const int* const left_base = reinterpret_cast<const int*>(left_.get());
+  const int* const right_base = reinterpret_cast<const int*>(right_.get());
+  uint32_t ties = 0;
+  for (unsigned v = 0; v < kNumLanes; v += 8) {
+    const __m256i offsets =
+        _mm256_add_epi32(lane_offsets, _mm256_set1_epi32(v * capacity_));
+    __m256i lh = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(left_head_.data() + v));
+    __m256i ll = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(left_len_.data() + v));
+    __m256i rh = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(right_head_.data() + v));
+    __m256i rl = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(right_len_.data() + v));
+    __m256i steps =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(steps_.data() + v));
+
+    const __m256i byte = _mm256_set1_epi32(0xff);
+    const __m256i cl = _mm256_and_si256(
+        _mm256_i32gather_epi32(
+            left_base,
+            _mm256_add_epi32(offsets, _mm256_and_si256(lh, mask)), 1),
+        byte);
+    const __m256i cr = _mm256_and_si256(
+        _mm256_i32gather_epi32(
+            right_base,
+            _mm256_add_epi32(offsets, _mm256_and_si256(rh, mask)), 1),
+        byte);
+
+    // Give the cards to both players (there is no scatter in AVX2).
+    alignas(32) std::array<uint32_t, 8> hi, lo, ltail, rtail;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(hi.data()),
+                       _mm256_max_epu32(cl, cr));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lo.data()),
+                       _mm256_min_epu32(cl, cr));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(ltail.data()),
+                       _mm256_add_epi32(lh, ll));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(rtail.data()),
+                       _mm256_add_epi32(rh, rl));
+    for (unsigned k = 0; k < 8; ++k) {
+      Card* const l = left(v + k);
+      Card* const r = right(v + k);
+      l[ltail[k] & mask_] = hi[k];
+      l[(ltail[k] + 1) & mask_] = lo[k];
+      r[rtail[k] & mask_] = hi[k];
+      r[(rtail[k] + 1) & mask_] = lo[k];
+    }
+
+    const __m256i active = _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(active_ >> v), lane_bits),
+        lane_bits);
+    const __m256i tie = _mm256_cmpeq_epi32(cl, cr);
+    // All ones for lanes that play.
+    const __m256i play = _mm256_andnot_si256(tie, active);
+    // +1 if left wins, -1 if right wins, 0 if not playing.
+    const __m256i left_delta = _mm256_and_si256(
+        _mm256_sub_epi32(
+            _mm256_and_si256(_mm256_cmpgt_epi32(cl, cr), two), one),
+        play);
+    lh = _mm256_sub_epi32(lh, play);
+    rh = _mm256_sub_epi32(rh, play);
+    ll = _mm256_add_epi32(ll, left_delta);
+    rl = _mm256_sub_epi32(rl, left_delta);
+    steps = _mm256_sub_epi32(steps, play);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(left_head_.data() + v), lh);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(left_len_.data() + v), ll);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(right_head_.data() + v), rh);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(right_len_.data() + v), rl);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(steps_.data() + v), steps);
+
+    ties |= static_cast<uint32_t>(_mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_and_si256(tie, active))))
+            << v;
+  }
+  return ties;
+}
+#endif
+
+void BatchEngine::ResolveTie(unsigned lane, Strategy strategy) {
+  Card* const l = left(lane);
+  Card* const r = right(lane);
+  uint32_t& lh = left_head_[lane];
+  uint32_t& ll = left_len_[lane];
+  uint32_t& rh = right_head_[lane];
+  uint32_t& rl = right_len_[lane];
+  ++steps_[lane];
+
+  unsigned num_ties = 0;
+  Card cl, cr;
+  do {
+    cl = l[lh++ & mask_];
+    --ll;
+    cr = r[rh++ & mask_];
+    --rl;
+    if (cl != cr) break;
+    ties_[num_ties++] = cl;
+  } while (ll != 0 && rl != 0);
+  if (cl == cr) return;  // The game ended during a tie.
+  BATAILLE_COUNT(Ties(num_ties, strategy));
+
+  const std::span<Card> ties(ties_.get(), num_ties);
+  if (cr < cl) {
+    PushRoundCards(cl, cr, ties, strategy,
+                   [&](Card card) { l[(lh + ll++) & mask_] = card; });
+  } else {
+    PushRoundCards(cr, cl, ties, strategy,
+                   [&](Card card) { r[(rh + rl++) & mask_] = card; });
+  }
+}
+
+PrefixSnapshot::State BatchEngine::Start(std::span<const Card> cards,
+                                         Strategy strategy, unsigned lane) {
+  return share_prefixes_
+             ? prefix_.Start(cards, strategy, left(lane), right(lane))
+             : prefix_.Deal(cards, left(lane), right(lane));
+}
+
+void BatchEngine::Load(unsigned lane, const PrefixSnapshot::State& state) {
+  left_head_[lane] = state.left_head;
+  left_len_[lane] = state.left_len;
+  right_head_[lane] = state.right_head;
+  right_len_[lane] = state.right_len;
+  steps_[lane] = state.steps;
+}
+
+PrefixSnapshot::State BatchEngine::Save(unsigned lane) const {
+  return {.left_head = left_head_[lane],
+          .left_len = left_len_[lane],
+          .right_head = right_head_[lane],
+          .right_len = right_len_[lane],
+          .steps = steps_[lane]};
+}
+
+Game::Result BatchEngine::LaneResult(unsigned lane) const {
+  return {.winner = left_len_[lane] == 0
+                        ? (right_len_[lane] == 0 ? Game::Winner::kDraw
+                                                 : Game::Winner::kRight)
+                        : Game::Winner::kLeft,
+          .num_steps = steps_[lane]};
+}
+
+template <typename StartFn, typename TieFn, typename EndFn,
+          typename UnresolvedFn>
+void BatchEngine::Run(Strategy strategy, unsigned max_steps, StartFn start,
+                      TieFn before_tie, EndFn end, UnresolvedFn unresolved) {
+  const auto fill = [&](unsigned lane) {
+    if (start(lane)) {
+      active_ |= uint32_t{1} << lane;
+    } else {
+      active_ &= ~(uint32_t{1} << lane);
+    }
+  };
+  for (unsigned lane = 0; lane < kNumLanes; ++lane) fill(lane);
+
+  while (active_ != 0) {
+#if defined(__x86_64__)
+    uint32_t ties = has_avx2_ ? RoundAvx2() : Round();
+#else
+    uint32_t ties = Round();
+#endif
+    BATAILLE_COUNT(Rounds(std::popcount(active_)));
+    for (; ties != 0; ties &= ties - 1) {
+      const unsigned lane = std::countr_zero(ties);
+      before_tie(lane);
+      ResolveTie(lane, strategy);
+    }
+    for (uint32_t active = active_; active != 0; active &= active - 1) {
+      const unsigned lane = std::countr_zero(active);
+      if (left_len_[lane] == 0 || right_len_[lane] == 0) {
+        end(lane);
+        fill(lane);
+      } else if (steps_[lane] >= max_steps) {
+        unresolved(lane);
+        fill(lane);
+      }
+    }
+  }
+}
+
+void BatchEngine::Play(std::span<const Card> deals,
+                       std::span<Game::Result> results, Strategy strategy,
+                       unsigned max_steps, std::vector<size_t>& unresolved) {
+  const unsigned n = deck_.num_cards();
+  assert(n >= 2);
+  assert(deals.size() == results.size() * n);
+  size_t next_deal = 0;
+  const auto start = [&](unsigned lane) {
+    for (; next_deal < results.size(); ++next_deal) {
+      const PrefixSnapshot::State state =
+          Start(deals.subspan(next_deal * n, n), strategy, lane);
+      if (state.winner) {
+        // The game ended in rounds shared with a previous deal.
+        results[next_deal] = {.winner = *state.winner,
+                              .num_steps = state.steps};
+        continue;
+      }
+      Load(lane, state);
+      deal_[lane] = next_deal++;
+      return true;
+    }
+    return false;
+  };
+  Run(
+      strategy, max_steps, start, [](unsigned) {},
+      [&](unsigned lane) { results[deal_[lane]] = LaneResult(lane); },
+      [&](unsigned lane) { unresolved.push_back(deal_[lane]); });
+}
+
+void BatchEngine::PlayBoth(std::span<const Card> deals,
+                           std::span<Game::Result> natural_results,
+                           std::span<Game::Result> optimized_results,
+                           unsigned max_steps,
+                           std::vector<size_t>& unresolved_natural,
+                           std::vector<size_t>& unresolved_optimized) {
+  const unsigned n = deck_.num_cards();
+  const size_t num_deals = natural_results.size();
+  assert(n >= 2);
+  assert(deals.size() == num_deals * n);
+  assert(optimized_results.size() == num_deals);
+  forks_.assign(num_deals, Fork::kSame);
+  if (fork_states_.size() < num_deals) {
+    fork_states_.resize(num_deals);
+    fork_rings_.resize(num_deals * 2 * capacity_);
+  }
+
+  // The natural games, until their first tie for the optimized games.
+  size_t next_deal = 0;
+  const auto start_natural = [&](unsigned lane) {
+    for (; next_deal < num_deals; ++next_deal) {
+      const PrefixSnapshot::State state =
+          Start(deals.subspan(next_deal * n, n), Strategy::kNatural, lane);
+      if (state.tied) forks_[next_deal] = Fork::kReplay;
+      if (state.winner) {
+        natural_results[next_deal] = {.winner = *state.winner,
+                                      .num_steps = state.steps};
+        if (!state.tied) {
+          optimized_results[next_deal] = natural_results[next_deal];
+        }
+        continue;
+      }
+      Load(lane, state);
+      deal_[lane] = next_deal++;
+      tied_ = (tied_ & ~(uint32_t{1} << lane)) |
+              (uint32_t{state.tied} << lane);
+      return true;
+    }
+    return false;
+  };
+  const auto before_tie = [&](unsigned lane) {
+    if ((tied_ >> lane) & 1) return;
+    tied_ |= uint32_t{1} << lane;
+    const size_t deal = deal_[lane];
+    forks_[deal] = Fork::kSaved;
+    fork_states_[deal] = Save(lane);
+    Card* const rings = fork_rings_.data() + deal * 2 * capacity_;
+    std::copy_n(left(lane), capacity_, rings);
+    std::copy_n(right(lane), capacity_, rings + capacity_);
+  };
+  Run(
+      Strategy::kNatural, max_steps, start_natural, before_tie,
+      [&](unsigned lane) {
+        natural_results[deal_[lane]] = LaneResult(lane);
+        if (!((tied_ >> lane) & 1)) {
+          optimized_results[deal_[lane]] = natural_results[deal_[lane]];
+        }
+      },
+      [&](unsigned lane) {
+        unresolved_natural.push_back(deal_[lane]);
+        if (!((tied_ >> lane) & 1)) {
+          unresolved_optimized.push_back(deal_[lane]);
+        }
+      });
+
+  // The optimized games that differ.
+  next_deal = 0;
+  const auto start_optimized = [&](unsigned lane) {
+    for (; next_deal < num_deals; ++next_deal) {
+      PrefixSnapshot::State state;
+      if (forks_[next_deal] == Fork::kSame) continue;
+      if (forks_[next_deal] == Fork::kSaved) {
+        state = fork_states_[next_deal];
+        const Card* const rings =
+            fork_rings_.data() + next_deal * 2 * capacity_;
+        std::copy_n(rings, capacity_, left(lane));
+        std::copy_n(rings + capacity_, capacity_, right(lane));
+      } else {
+        state = Start(deals.subspan(next_deal * n, n), Strategy::kOptimized,
+                      lane);
+        if (state.winner) {
+          optimized_results[next_deal] = {.winner = *state.winner,
+                                          .num_steps = state.steps};
+          continue;
+        }
+      }
+      Load(lane, state);
+      deal_[lane] = next_deal++;
+      return true;
+    }
+    return false;
+  };
+  Run(
+      Strategy::kOptimized, max_steps, start_optimized, [](unsigned) {},
+      [&](unsigned lane) { optimized_results[deal_[lane]] = LaneResult(lane); },
+      [&](unsigned lane) { unresolved_optimized.push_back(deal_[lane]); });
+}
+
+}  // namespace bataille
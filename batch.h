@@ -0,0 +1,132 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "bataille.h"
+#include "prefix_snapshot.h"
+
+namespace bataille {
+
+// Plays many games in lockstep, in a structure-of-arrays layout: all lanes
+// compare their top cards and give them to the winner in the same loop, and
+// only lanes with a tie take a scalar path. Lanes are refilled with new deals
+// as soon as their game ends. With `SetSharePrefixes`, games of consecutive
+// deals that share their first cards start from the same snapshot (see
+// `PrefixSnapshot`).
+//
+// There is no cycle detection: games that do not end within a given number of
+// rounds are reported as unresolved and should be played by `GameArena`.
+class BatchEngine {
+ public:
+  static constexpr unsigned kNumLanes = 16;
+
+  explicit BatchEngine(Deck deck);
+
+  // Whether games start from a snapshot shared with the previous deal. This
+  // only pays off when deals are permutations in lexicographic order, as in
+  // exhaustive explorations: other deals miss the snapshot and pay for
+  // computing a new one. Off by default.
+  void SetSharePrefixes(bool share) { share_prefixes_ = share; }
+
+  // Plays the games of `deals` (`deck.num_cards()` cards each, dealt as in
+  // `Game::Deal`). The results of games that end within `max_steps` rounds are
+  // written to `results`, the indices of other games are appended to
+  // `unresolved`.
+  void Play(std::span<const Card> deals, std::span<Game::Result> results,
+            Strategy strategy, unsigned max_steps,
+            std::vector<size_t>& unresolved);
+
+  // Like `Play` with both strategies, writing to `natural_results` and
+  // `optimized_results`. Games are the same with both strategies until their
+  // first tie: each game is played once until then, and both variants are
+  // played from there.
+  void PlayBoth(std::span<const Card> deals,
+                std::span<Game::Result> natural_results,
+                std::span<Game::Result> optimized_results, unsigned max_steps,
+                std::vector<size_t>& unresolved_natural,
+                std::vector<size_t>& unresolved_optimized);
+
+ private:
+  // Plays games on the lanes until there are none left. `start(lane)` deals a
+  // game to the lane (see `Load`) and returns true, or returns false if there
+  // are no more games. `end(lane)` is called when the game of a lane ends,
+  // `unresolved(lane)` when it reaches `max_steps` rounds, and
+  // `before_tie(lane)` before resolving a tie.
+  template <typename StartFn, typename TieFn, typename EndFn,
+            typename UnresolvedFn>
+  void Run(Strategy strategy, unsigned max_steps, StartFn start,
+           TieFn before_tie, EndFn end, UnresolvedFn unresolved);
+
+  // Writes the start of the game of `cards` to the rings of `lane` (see
+  // `PrefixSnapshot`), and returns its state.
+  PrefixSnapshot::State Start(std::span<const Card> cards, Strategy strategy,
+                              unsigned lane);
+  // Sets the state of a lane, whose rings have the cards of `state`.
+  void Load(unsigned lane, const PrefixSnapshot::State& state);
+  // Returns the state of a lane.
+  PrefixSnapshot::State Save(unsigned lane) const;
+  // The result of the game of a lane, which is over.
+  Game::Result LaneResult(unsigned lane) const;
+
+  // Plays one round on all active lanes without a tie. Returns the mask of
+  // active lanes with a tie, which have not been modified.
+  uint32_t Round();
+#if defined(__x86_64__)
+  uint32_t RoundAvx2();
+#endif
+
+  // Plays one round on a lane with a tie, like `Game::Step`.
+  void ResolveTie(unsigned lane, Strategy strategy);
+
+  Card* left(unsigned lane) { return left_.get() + lane * capacity_; }
+  Card* right(unsigned lane) { return right_.get() + lane * capacity_; }
+
+  const Deck deck_;
+  // Each ring has a power-of-two capacity of at least `num_cards + 2`: cards
+  // are given to both players, and only the winner keeps them by incrementing
+  // its length. The extra cards of the loser land past its last card.
+  const uint32_t capacity_;
+  const uint32_t mask_;
+  const bool has_avx2_;
+  std::unique_ptr<Card[]> left_;
+  std::unique_ptr<Card[]> right_;
+  std::unique_ptr<Card[]> ties_;
+  PrefixSnapshot prefix_;
+  bool share_prefixes_ = false;
+  // Rings positions are not wrapped, use `position & mask_`.
+  alignas(32) std::array<uint32_t, kNumLanes> left_head_;
+  alignas(32) std::array<uint32_t, kNumLanes> left_len_;
+  alignas(32) std::array<uint32_t, kNumLanes> right_head_;
+  alignas(32) std::array<uint32_t, kNumLanes> right_len_;
+  alignas(32) std::array<uint32_t, kNumLanes> steps_;
+  // The index of the deal played by each lane.
+  std::array<size_t, kNumLanes> deal_;
+  // The mask of lanes that are playing a game.
+  uint32_t active_ = 0;
+
+  // For `PlayBoth`, how the optimized game of each deal is played.
+  enum class Fork : uint8_t {
+    // Same as the natural game, which had no tie.
+    kSame,
+    // From the state before the first tie, saved in `fork_states_` and
+    // `fork_rings_`.
+    kSaved,
+    // From the start: the natural game started from a snapshot with a tie.
+    kReplay,
+  };
+  std::vector<Fork> forks_;
+  std::vector<PrefixSnapshot::State> fork_states_;
+  std::vector<Card> fork_rings_;
+  // The mask of lanes whose natural game had a tie.
+  uint32_t tied_ = 0;
+};
+
+}  // namespace bataille
+
+#endif  // BATCH_H
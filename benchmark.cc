@@ -1,26 +1,494 @@
 
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include "bataille.h"
+#include "engine.h"
+#include "multiset.h"
+#include "outcome_cache.h"
+#include "rng.h"
 
 namespace bataille {
 namespace {
 
-template <Strategy strategy>
-void BM_Play(benchmark::State& state) {
-  GameArena arena({.colors = 4, .values = 8});
+// Decks that we explore, and the strategy, as benchmark arguments.
+void DecksAndStrategies(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"colors", "values", "optimized"});
+  for (const auto& [colors, values] :
+       {std::pair{4, 5}, std::pair{4, 8}, std::pair{4, 13}, std::pair{1, 64}}) {
+    b->Args({colors, values, 0});
+    b->Args({colors, values, 1});
+  }
+}
+
+Deck DeckArg(const benchmark::State& state) {
+  return {.colors = static_cast<unsigned>(state.range(0)),
+          .values = static_cast<unsigned>(state.range(1))};
+}
+
+Strategy StrategyArg(const benchmark::State& state) {
+  return state.range(2) ? Strategy::kOptimized : Strategy::kNatural;
+}
+
+// Returns `num_deals` random deals of `deck`, one after the other. Benchmarks
+// use the same seed, so that they play the same deals in every build.
+std::vector<Card> RandomDeals(Deck deck, int num_deals) {
+  std::mt19937 gen(42);
+  std::vector<Card> cards = deck.Make();
+  std::vector<Card> deals;
+  for (int i = 0; i < num_deals; ++i) {
+    std::shuffle(cards.begin(), cards.end(), gen);
+    deals.insert(deals.end(), cards.begin(), cards.end());
+  }
+  return deals;
+}
+
+// Kinds of deals in a corpus.
+enum class DealKind {
+  // Random deals.
+  kRandom,
+  // The longest games (without a cycle) among random deals.
+  kLong,
+  // Games that end in a cycle.
+  kCyclic,
+  // The games with the largest fraction of rounds with a tie. There are no
+  // ties with one color.
+  kTies,
+};
+
+// Returns the number of rounds of the game of `cards` with a tie. The game
+// must end within `num_steps` rounds.
+unsigned NumTies(Deck deck, std::span<const Card> cards, Strategy strategy,
+                 unsigned num_steps) {
+  Game game(deck);
+  game.Deal(cards);
+  unsigned num_ties = 0;
+  for (unsigned i = 0; i < num_steps; ++i) {
+    const size_t size = game.left().size();
+    const bool over = game.Step(strategy);
+    // Without a tie, exactly one card changes hands.
+    const size_t new_size = game.left().size();
+    num_ties += new_size != size + 1 && new_size + 1 != size;
+    if (over) break;
+  }
+  return num_ties;
+}
+
+// Returns (up to) `kCorpusSize` deals of the given kind, selected among a
+// fixed sample of random deals.
+constexpr int kCorpusSize = 64;
+std::vector<Card> MakeCorpus(Deck deck, Strategy strategy, DealKind kind) {
+  constexpr int kSampleSize = 4096;
+  const unsigned n = deck.num_cards();
+  const std::vector<Card> sample = RandomDeals(deck, kSampleSize);
+  const auto deal = [&](int i) { return std::span(sample).subspan(i * n, n); };
+  if (kind == DealKind::kRandom) {
+    return std::vector<Card>(sample.begin(), sample.begin() + kCorpusSize * n);
+  }
+
+  const std::unique_ptr<Engine> engine = MakeEngine(deck);
+  // Deals by decreasing score, then by index.
+  std::vector<std::pair<double, int>> scored;
+  for (int i = 0; i < kSampleSize; ++i) {
+    const Game::Result result = engine->Play(deal(i), strategy);
+    const bool cycle = result.winner == Game::Winner::kCycle;
+    switch (kind) {
+      case DealKind::kRandom:
+        break;
+      case DealKind::kLong:
+        if (!cycle) {
+          scored.emplace_back(-static_cast<double>(result.num_steps), i);
+        }
+        break;
+      case DealKind::kCyclic:
+        if (cycle) scored.emplace_back(0, i);
+        break;
+      case DealKind::kTies:
+        if (!cycle) {
+          const unsigned num_ties =
+              NumTies(deck, deal(i), strategy, result.num_steps);
+          if (num_ties > 0) {
+            scored.emplace_back(
+                -static_cast<double>(num_ties) / result.num_steps, i);
+          }
+        }
+        break;
+    }
+  }
+  std::sort(scored.begin(), scored.end());
+  std::vector<Card> deals;
+  for (int i = 0; i < std::min<int>(kCorpusSize, scored.size()); ++i) {
+    const auto cards = deal(scored[i].second);
+    deals.insert(deals.end(), cards.begin(), cards.end());
+  }
+  return deals;
+}
+
+// Same as `MakeCorpus`, but builds each corpus once: benchmarks are run
+// several times to find their number of iterations.
+const std::vector<Card>& Corpus(Deck deck, Strategy strategy, DealKind kind) {
+  static auto* const corpora =
+      new std::map<std::tuple<unsigned, unsigned, Strategy, DealKind>,
+                   std::vector<Card>>();
+  const auto key = std::make_tuple(deck.colors, deck.values, strategy, kind);
+  auto it = corpora->find(key);
+  if (it == corpora->end()) {
+    it = corpora->emplace(key, MakeCorpus(deck, strategy, kind)).first;
+  }
+  return it->second;
+}
+
+// Plays a corpus of deals one by one. Reports games and rounds per second.
+template <DealKind kind>
+void BM_Corpus(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  const Strategy strategy = StrategyArg(state);
+  const std::vector<Card>& deals = Corpus(deck, strategy, kind);
+  const size_t num_deals = deals.size() / deck.num_cards();
+  if (num_deals == 0) {
+    state.SkipWithError("no such deals");
+    return;
+  }
+
+  GameArena arena(deck);
+  uint64_t num_rounds = 0;
+  for (const auto s : state) {
+    for (size_t i = 0; i < num_deals; ++i) {
+      const Game::Result result = arena.Play(
+          std::span(deals).subspan(i * deck.num_cards(), deck.num_cards()),
+          strategy);
+      num_rounds += result.num_steps;
+    }
+  }
+  state.counters["games"] = benchmark::Counter(
+      state.iterations() * num_deals, benchmark::Counter::kIsRate);
+  state.counters["rounds"] =
+      benchmark::Counter(num_rounds, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Corpus<DealKind::kRandom>)->Apply(DecksAndStrategies);
+BENCHMARK(BM_Corpus<DealKind::kLong>)->Apply(DecksAndStrategies);
+// Cycles are rare with the decks above.
+BENCHMARK(BM_Corpus<DealKind::kCyclic>)
+    ->ArgNames({"colors", "values", "optimized"})
+    ->Args({1, 9, 0})
+    ->Args({1, 9, 1})
+    ->Args({1, 22, 0})
+    ->Args({4, 3, 0});
+BENCHMARK(BM_Corpus<DealKind::kTies>)->Apply(DecksAndStrategies);
+
+// The inner loop of `explore exhaustive` on a slice of the permutations of a
+// deck, from the middle of the permutations: enumerating, skipping mirrored
+// deals, and playing in batches.
+void BM_ExhaustiveSlice(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  const Strategy strategy = StrategyArg(state);
+  constexpr uint64_t kSliceSize = 1 << 16;
+  constexpr size_t kBatchSize = 1024;
+  std::vector<Card> cards = deck.Make();
+  const uint64_t begin = NumPermutations(cards) / 2;
+
+  GameArena arena(deck);
+  arena.SetLexicographicDeals(true);
+  std::vector<Card> deals;
+  std::vector<Game::Result> results(kBatchSize);
+  uint64_t num_games = 0;
+  for (const auto s : state) {
+    Unrank(begin, cards);
+    for (uint64_t rank = begin + SkipToCanonicalDeal(cards);
+         rank < begin + kSliceSize; rank += 1 + SkipToCanonicalDeal(cards)) {
+      deals.insert(deals.end(), cards.begin(), cards.end());
+      if (deals.size() == kBatchSize * cards.size()) {
+        arena.PlayBatch(deals, results, strategy);
+        deals.clear();
+        num_games += kBatchSize;
+      }
+      std::next_permutation(cards.begin(), cards.end());
+    }
+    const size_t num_left = deals.size() / cards.size();
+    arena.PlayBatch(deals, std::span(results).first(num_left), strategy);
+    deals.clear();
+    num_games += num_left;
+  }
+  state.counters["games"] =
+      benchmark::Counter(num_games, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ExhaustiveSlice)
+    ->ArgNames({"colors", "values", "optimized"})
+    ->Args({4, 5, 0})
+    ->Args({4, 5, 1});
+
+// Shuffles deals as `explore random` does with the generator `kRng`.
+template <Rng kRng>
+class Shuffler {
+ public:
+  void operator()(std::vector<Card>& cards) {
+    if constexpr (kRng == Rng::kMt19937) {
+      std::shuffle(cards.begin(), cards.end(), mt19937_);
+    } else {
+      Shuffle(cards, xoshiro_);
+    }
+  }
+
+ private:
+  std::mt19937 mt19937_{42};
+  Xoshiro256StarStar xoshiro_{42};
+};
+
+// The inner loop of `explore random`: shuffling the last deal, and playing in
+// batches. `BM_Shuffle` measures the shuffles alone.
+template <Rng kRng>
+void BM_RandomLoop(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  const Strategy strategy = StrategyArg(state);
+  constexpr size_t kBatchSize = 1024;
+  Shuffler<kRng> shuffle;
+  std::vector<Card> cards = deck.Make();
+  std::vector<Card> deals;
+  std::vector<Game::Result> results(kBatchSize);
+  GameArena arena(deck);
+  for (const auto s : state) {
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      shuffle(cards);
+      deals.insert(deals.end(), cards.begin(), cards.end());
+    }
+    arena.PlayBatch(deals, results, strategy);
+    deals.clear();
+  }
+  state.counters["games"] = benchmark::Counter(
+      state.iterations() * kBatchSize, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RandomLoop<Rng::kMt19937>)->Apply(DecksAndStrategies);
+BENCHMARK(BM_RandomLoop<Rng::kXoshiro256StarStar>)->Apply(DecksAndStrategies);
+
+template <Rng kRng>
+void BM_Shuffle(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  Shuffler<kRng> shuffle;
+  std::vector<Card> cards = deck.Make();
+  for (const auto s : state) {
+    shuffle(cards);
+    benchmark::DoNotOptimize(cards.data());
+  }
+  state.counters["shuffles"] =
+      benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Shuffle<Rng::kMt19937>)
+    ->ArgNames({"colors", "values"})
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13})
+    ->Args({1, 64});
+BENCHMARK(BM_Shuffle<Rng::kXoshiro256StarStar>)
+    ->ArgNames({"colors", "values"})
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13})
+    ->Args({1, 64});
+
+// The longest known game for 4x7 (2505 rounds), which mostly has runs of
+// rounds without ties.
+template <std::unique_ptr<Engine> (*make)(Deck)>
+void BM_PlayLongest(benchmark::State& state) {
+  const Deck deck = {.colors = 4, .values = 7};
   const std::vector<Card> cards = {
-      3, 3, 5, 4, 2, 2, 5, 8, 7, 2, 6, 3, 7, 6, 5, 6,
+      5, 1, 2, 4, 6, 6, 1, 5, 7, 4, 1, 7, 2, 3,
       //
-      1, 8, 2, 4, 8, 1, 5, 1, 1, 6, 7, 3, 7, 4, 8, 4};
+      5, 2, 7, 6, 4, 1, 5, 3, 2, 4, 7, 3, 6, 3};
+  const std::unique_ptr<Engine> engine = make(deck);
+  for (const auto s : state) {
+    auto result = engine->Play(cards, Strategy::kOptimized);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_PlayLongest<MakeGenericEngine>);
+BENCHMARK(BM_PlayLongest<MakeFixedEngine>);
 
+// Plays a record deal from `results/`, which takes `num_steps` rounds.
+void BM_Record(benchmark::State& state, Deck deck, Strategy strategy,
+               std::vector<Card> cards, unsigned num_steps) {
+  GameArena arena(deck);
+  if (arena.Play(cards, strategy).num_steps != num_steps) {
+    state.SkipWithError("not a record");
+    return;
+  }
   for (const auto s : state) {
     auto result = arena.Play(cards, strategy);
     benchmark::DoNotOptimize(result);
   }
+  state.counters["rounds"] = benchmark::Counter(
+      state.iterations() * num_steps, benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_Record, c4v5_longest, Deck{.colors = 4, .values = 5},
+                  Strategy::kNatural,
+                  std::vector<Card>{1, 1, 1, 2, 1, 5, 3, 4, 4, 5,  //
+                                    2, 3, 5, 3, 4, 5, 2, 3, 4, 2},
+                  453);
+BENCHMARK_CAPTURE(BM_Record, c4v8_opt_longest, Deck{.colors = 4, .values = 8},
+                  Strategy::kOptimized,
+                  std::vector<Card>{2, 8, 8, 5, 6, 4, 1, 5, 1, 6, 4, 6, 2, 1,
+                                    7, 8,  //
+                                    8, 1, 4, 2, 2, 3, 5, 5, 7, 7, 3, 7, 3, 3,
+                                    4, 6},
+                  1757);
+BENCHMARK_CAPTURE(BM_Record, c4v13_longest, Deck{.colors = 4, .values = 13},
+                  Strategy::kNatural,
+                  std::vector<Card>{7,  4,  10, 12, 11, 9,  8, 1,  2,
+                                    6,  13, 2,  6,  2,  11, 6, 1,  13,
+                                    1,  11, 5,  12, 5,  12, 4, 7,  //
+                                    9,  9,  10, 7,  8,  4,  9, 6,  10,
+                                    10, 3,  3,  5,  3,  8,  13, 3, 11,
+                                    7,  2,  4,  12, 1,  8,  5,  13},
+                  5610);
+BENCHMARK_CAPTURE(BM_Record, c1v64_longest, Deck{.colors = 1, .values = 64},
+                  Strategy::kNatural,
+                  std::vector<Card>{7,  52, 62, 59, 39, 8,  33, 41, 63, 57, 34,
+                                    36, 43, 20, 12, 27, 9,  38, 45, 40, 50, 53,
+                                    10, 49, 61, 31, 46, 21, 58, 19, 5,  30,  //
+                                    22, 29, 4,  54, 32, 23, 35, 44, 48, 60, 14,
+                                    47, 25, 55, 24, 42, 26, 11, 18, 13, 15, 1,
+                                    6,  2,  56, 64, 37, 51, 17, 16, 3,  28},
+                  7568);
+BENCHMARK_CAPTURE(BM_Record, c4v11_shortest_cycle,
+                  Deck{.colors = 4, .values = 11}, Strategy::kNatural,
+                  std::vector<Card>{1, 3, 4, 9, 4, 9, 6, 5, 10, 7, 6, 10, 5, 7,
+                                    10, 11, 11, 2, 8, 7, 9, 5,  //
+                                    8, 1, 4, 1, 4, 8, 2, 11, 6, 3, 7, 2, 8, 3,
+                                    9, 1, 2, 3, 10, 5, 6, 11},
+                  1152);
+
+// Plays random deals one by one or in a batch.
+template <Strategy strategy, bool batch>
+void BM_PlayRandom(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  constexpr int kNumDeals = 1024;
+  const std::vector<Card> deals = RandomDeals(deck, kNumDeals);
+
+  GameArena arena(deck);
+  std::vector<Game::Result> results(kNumDeals);
+  for (const auto s : state) {
+    if (batch) {
+      arena.PlayBatch(deals, results, strategy);
+    } else {
+      for (int i = 0; i < kNumDeals; ++i) {
+        results[i] = arena.Play(
+            std::span(deals).subspan(i * deck.num_cards(), deck.num_cards()),
+            strategy);
+      }
+    }
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumDeals);
+}
+BENCHMARK(BM_PlayRandom<Strategy::kNatural, false>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({1, 16});
+BENCHMARK(BM_PlayRandom<Strategy::kNatural, true>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({1, 16});
+
+// Plays random deals with both strategies, in two batches or in one pass that
+// shares the rounds before the first tie.
+template <bool shared>
+void BM_PlayBoth(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  constexpr int kNumDeals = 1024;
+  const std::vector<Card> deals = RandomDeals(deck, kNumDeals);
+
+  GameArena natural(deck), optimized(deck);
+  std::vector<Game::Result> natural_results(kNumDeals);
+  std::vector<Game::Result> optimized_results(kNumDeals);
+  for (const auto s : state) {
+    if (shared) {
+      natural.PlayBatchBoth(deals, natural_results, optimized_results,
+                            optimized);
+    } else {
+      natural.PlayBatch(deals, natural_results, Strategy::kNatural);
+      optimized.PlayBatch(deals, optimized_results, Strategy::kOptimized);
+    }
+    benchmark::DoNotOptimize(natural_results);
+    benchmark::DoNotOptimize(optimized_results);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumDeals);
+}
+BENCHMARK(BM_PlayBoth<false>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13})
+    ->Args({1, 16});
+BENCHMARK(BM_PlayBoth<true>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13})
+    ->Args({1, 16});
+
+// Plays random deals with an outcome cache. After the first iteration, most
+// games end at their first lookup.
+void BM_PlayCached(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  constexpr int kNumDeals = 1024;
+  const std::vector<Card> deals = RandomDeals(deck, kNumDeals);
+
+  OutcomeCache cache(1 << 24);
+  GameArena arena(deck);
+  arena.SetOutcomeCache(&cache);
+  for (const auto s : state) {
+    for (int i = 0; i < kNumDeals; ++i) {
+      benchmark::DoNotOptimize(arena.Play(
+          std::span(deals).subspan(i * deck.num_cards(), deck.num_cards()),
+          Strategy::kNatural));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumDeals);
+}
+BENCHMARK(BM_PlayCached)->Args({4, 8})->Args({4, 13})->Args({1, 64});
+
+// Plays random deals with the engine made by `make`, to compare engines.
+template <std::unique_ptr<Engine> (*make)(Deck), Strategy strategy>
+void BM_PlayEngine(benchmark::State& state) {
+  const Deck deck = DeckArg(state);
+  constexpr int kNumDeals = 256;
+  const std::vector<Card> deals = RandomDeals(deck, kNumDeals);
+
+  const std::unique_ptr<Engine> engine = make(deck);
+  std::vector<Game::Result> results(kNumDeals);
+  for (const auto s : state) {
+    for (int i = 0; i < kNumDeals; ++i) {
+      results[i] = engine->Play(
+          std::span(deals).subspan(i * deck.num_cards(), deck.num_cards()),
+          strategy);
+    }
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumDeals);
 }
-BENCHMARK(BM_Play<Strategy::kNatural>);
-BENCHMARK(BM_Play<Strategy::kOptimized>);
+BENCHMARK(BM_PlayEngine<MakeGenericEngine, Strategy::kNatural>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13})
+    ->Args({1, 64});
+BENCHMARK(BM_PlayEngine<MakeFixedEngine, Strategy::kNatural>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13});
+BENCHMARK(BM_PlayEngine<MakeGenericEngine, Strategy::kOptimized>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13});
+BENCHMARK(BM_PlayEngine<MakeFixedEngine, Strategy::kOptimized>)
+    ->Args({4, 5})
+    ->Args({4, 8})
+    ->Args({4, 13});
 
 }  // namespace
 }  // namespace bataille
\ No newline at end of file
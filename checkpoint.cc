@@ -0,0 +1,232 @@
+#include "checkpoint.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+constexpr std::string_view kCheckpointHeader = "bataille-checkpoint 3";
+
+// Writes `contents` to `path` and flushes it to the disk.
+bool WriteFileSynced(const std::string& path, std::string_view contents) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  while (!contents.empty()) {
+    const ssize_t written = write(fd, contents.data(), contents.size());
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      close(fd);
+      return false;
+    }
+    contents.remove_prefix(written);
+  }
+  const bool synced = fsync(fd) == 0;
+  return close(fd) == 0 && synced;
+}
+
+// Flushes the entries of directory `path` (e.g. a rename) to the disk.
+bool SyncDirectory(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) return false;
+  const bool synced = fsync(fd) == 0;
+  close(fd);
+  return synced;
+}
+
+void WriteCards(const std::vector<Card>& cards, std::ostream& os) {
+  os << cards.size();
+  for (const Card card : cards) os << " " << static_cast<unsigned>(card);
+}
+
+bool ReadCards(std::istream& is, std::vector<Card>& cards) {
+  size_t size = 0;
+  if (!(is >> size)) return false;
+  cards.resize(size);
+  for (Card& card : cards) {
+    unsigned value = 0;
+    if (!(is >> value)) return false;
+    card = value;
+  }
+  return true;
+}
+
+// Reads `key` followed by a value.
+template <typename T>
+bool ReadField(std::istream& is, std::string_view key, T& value) {
+  std::string actual_key;
+  return is >> actual_key && actual_key == key && is >> value;
+}
+
+void WriteEstimates(const GameEstimates& estimates, std::ostream& os) {
+  os << "estimates";
+  for (const uint64_t count : estimates.num_winners) os << " " << count;
+  // Enough digits to read back the same double.
+  os << " " << estimates.length_sum << " "
+     << std::setprecision(std::numeric_limits<double>::max_digits10)
+     << estimates.length_square_sum << " "
+     << estimates.length_histogram.size();
+  for (const uint64_t count : estimates.length_histogram) os << " " << count;
+  os << "\n";
+}
+
+bool ReadEstimates(std::istream& is, GameEstimates& estimates) {
+  std::string key;
+  if (!(is >> key) || key != "estimates") return false;
+  for (uint64_t& count : estimates.num_winners) {
+    if (!(is >> count)) return false;
+  }
+  size_t num_buckets = 0;
+  if (!(is >> estimates.length_sum >> estimates.length_square_sum >>
+        num_buckets)) {
+    return false;
+  }
+  estimates.length_histogram.resize(num_buckets);
+  for (uint64_t& count : estimates.length_histogram) {
+    if (!(is >> count)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void WriteStats(const GameArena::Stats& stats, std::ostream& os) {
+  os << "num_played " << stats.num_played << "\n";
+  os << "num_played_with_cycle " << stats.num_played_with_cycle << "\n";
+  os << "cache_lookups " << stats.cache.lookups << "\n";
+  os << "cache_hits " << stats.cache.hits << "\n";
+  os << "longest " << stats.longest_len << " ";
+  WriteCards(stats.longest.Cards(), os);
+  os << "\nshortest_with_cycle " << stats.shortest_with_cycle_len << " "
+     << stats.shortest_with_cycle_mu << " "
+     << stats.shortest_with_cycle_lambda << " ";
+  WriteCards(stats.shortest_with_cycle.Cards(), os);
+  os << "\n";
+}
+
+bool ReadStats(std::istream& is, GameArena::Stats& stats) {
+  std::vector<Card> longest;
+  std::vector<Card> shortest_with_cycle;
+  if (!ReadField(is, "num_played", stats.num_played) ||
+      !ReadField(is, "num_played_with_cycle", stats.num_played_with_cycle) ||
+      !ReadField(is, "cache_lookups", stats.cache.lookups) ||
+      !ReadField(is, "cache_hits", stats.cache.hits) ||
+      !ReadField(is, "longest", stats.longest_len) ||
+      !ReadCards(is, longest) ||
+      !ReadField(is, "shortest_with_cycle", stats.shortest_with_cycle_len) ||
+      !(is >> stats.shortest_with_cycle_mu >>
+        stats.shortest_with_cycle_lambda) ||
+      !ReadCards(is, shortest_with_cycle)) {
+    return false;
+  }
+  const unsigned num_cards = stats.longest.deck().num_cards();
+  for (const auto& [cards, game] :
+       {std::pair(&longest, &stats.longest),
+        std::pair(&shortest_with_cycle, &stats.shortest_with_cycle)}) {
+    if (cards->empty()) continue;
+    if (cards->size() != num_cards) return false;
+    game->Deal(*cards);
+  }
+  return true;
+}
+
+bool SaveCheckpoint(const Checkpoint& checkpoint, const std::string& path) {
+  std::ostringstream os;
+  os << kCheckpointHeader << "\n";
+  os << "mode " << checkpoint.mode << "\n";
+  os << "deck " << checkpoint.deck.colors << " " << checkpoint.deck.values
+     << "\n";
+  os << "strategy " << StrategyName(checkpoint.strategy) << "\n";
+  os << "seed " << checkpoint.seed << "\n";
+  os << "rng " << RngName(checkpoint.rng) << "\n";
+  os << "threads " << checkpoint.num_threads << "\n";
+  os << "elapsed " << checkpoint.elapsed.count() << "\n";
+  WriteStats(checkpoint.stats, os);
+  WriteEstimates(checkpoint.estimates, os);
+  os << "remaining " << checkpoint.remaining.size() << "\n";
+  for (const IndexRange& range : checkpoint.remaining) {
+    os << range.begin << " " << range.end << "\n";
+  }
+  os << "thread_states " << checkpoint.thread_states.size() << "\n";
+  for (const std::string& state : checkpoint.thread_states) {
+    os << state << "\n";
+  }
+  // The data of the temporary file must reach the disk before the rename, and
+  // the rename itself before we rely on it: otherwise a crash can leave an
+  // empty or truncated checkpoint in place of the previous one.
+  const std::string tmp_path = path + ".tmp";
+  if (!WriteFileSynced(tmp_path, os.str()) ||
+      std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    return false;
+  }
+  const size_t slash = path.rfind('/');
+  return SyncDirectory(slash == std::string::npos
+                           ? "."
+                           : path.substr(0, slash == 0 ? 1 : slash));
+}
+
+std::optional<Checkpoint> LoadCheckpoint(const std::string& path) {
+  std::ifstream is(path);
+  std::string header;
+  if (!std::getline(is, header) || header != kCheckpointHeader) {
+    return std::nullopt;
+  }
+  std::string mode;
+  Deck deck;
+  std::string strategy;
+  if (!ReadField(is, "mode", mode) || !ReadField(is, "deck", deck.colors) ||
+      !(is >> deck.values) || !ReadField(is, "strategy", strategy)) {
+    return std::nullopt;
+  }
+  const std::optional<Strategy> parsed_strategy = ParseStrategy(strategy);
+  if (!parsed_strategy) return std::nullopt;
+  Checkpoint checkpoint(deck);
+  checkpoint.mode = mode;
+  checkpoint.strategy = *parsed_strategy;
+  long long elapsed = 0;
+  size_t num_ranges = 0;
+  std::string rng;
+  if (!ReadField(is, "seed", checkpoint.seed) || !ReadField(is, "rng", rng)) {
+    return std::nullopt;
+  }
+  const std::optional<Rng> parsed_rng = ParseRng(rng);
+  if (!parsed_rng) return std::nullopt;
+  checkpoint.rng = *parsed_rng;
+  if (!ReadField(is, "threads", checkpoint.num_threads) ||
+      !ReadField(is, "elapsed", elapsed) ||
+      !ReadStats(is, checkpoint.stats) ||
+      !ReadEstimates(is, checkpoint.estimates) ||
+      !ReadField(is, "remaining", num_ranges)) {
+    return std::nullopt;
+  }
+  checkpoint.elapsed = std::chrono::seconds(elapsed);
+  checkpoint.remaining.resize(num_ranges);
+  for (IndexRange& range : checkpoint.remaining) {
+    if (!(is >> range.begin >> range.end)) return std::nullopt;
+  }
+  size_t num_states = 0;
+  if (!ReadField(is, "thread_states", num_states)) return std::nullopt;
+  is >> std::ws;
+  checkpoint.thread_states.resize(num_states);
+  for (std::string& state : checkpoint.thread_states) {
+    if (!std::getline(is, state)) return std::nullopt;
+  }
+  return checkpoint;
+}
+
+}  // namespace bataille
@@ -0,0 +1,57 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <chrono>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bataille.h"
+#include "estimates.h"
+#include "rng.h"
+#include "work_stealing.h"
+
+namespace bataille {
+
+// Writes `stats` as text, including the record deals.
+void WriteStats(const GameArena::Stats& stats, std::ostream& os);
+
+// Reads stats written by `WriteStats` into `stats`, which must be for the same
+// deck. Returns false on error.
+bool ReadStats(std::istream& is, GameArena::Stats& stats);
+
+// The state of an exploration, saved periodically so that it can be resumed.
+struct Checkpoint {
+  explicit Checkpoint(Deck d) : deck(d), stats(d) {}
+
+  std::string mode;  // "exhaustive" or "random".
+  Deck deck;
+  Strategy strategy = Strategy::kNatural;
+  unsigned seed = 0;
+  // Random mode: the random generator.
+  Rng rng = Rng::kXoshiro256StarStar;
+  unsigned num_threads = 1;
+  std::chrono::seconds elapsed{0};
+  // The stats of all games played so far.
+  GameArena::Stats stats;
+  // Random mode: the estimates of all games played so far.
+  GameEstimates estimates;
+  // Exhaustive mode: the ranks of the deals that remain to be played.
+  std::vector<IndexRange> remaining;
+  // Random mode: the state of each thread, as a single line of text.
+  std::vector<std::string> thread_states;
+};
+
+// Writes `checkpoint` to `path`. The file is replaced atomically, so that a
+// crash leaves either the previous or the new checkpoint. Returns false on
+// error.
+bool SaveCheckpoint(const Checkpoint& checkpoint, const std::string& path);
+
+// Returns std::nullopt if the file cannot be read, or is a checkpoint of
+// another version.
+std::optional<Checkpoint> LoadCheckpoint(const std::string& path);
+
+}  // namespace bataille
+
+#endif  // CHECKPOINT_H
@@ -0,0 +1,110 @@
+#include "checkpoint.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+TEST(CheckpointTest, StatsRoundTrip) {
+  const Deck deck = {.colors = 1, .values = 7};
+  GameArena arena(deck);
+  std::vector<Card> cards = deck.Make();
+  do {
+    arena.Play(cards, Strategy::kNatural);
+  } while (std::next_permutation(cards.begin(), cards.end()));
+
+  std::stringstream ss;
+  WriteStats(arena.stats(), ss);
+  GameArena::Stats stats(deck);
+  ASSERT_TRUE(ReadStats(ss, stats));
+  const GameArena::Stats& expected = arena.stats();
+  EXPECT_EQ(stats.num_played, expected.num_played);
+  EXPECT_EQ(stats.num_played_with_cycle, expected.num_played_with_cycle);
+  EXPECT_EQ(stats.longest_len, expected.longest_len);
+  EXPECT_EQ(stats.longest, expected.longest);
+  EXPECT_EQ(stats.shortest_with_cycle_len, expected.shortest_with_cycle_len);
+  EXPECT_EQ(stats.shortest_with_cycle_mu, expected.shortest_with_cycle_mu);
+  EXPECT_EQ(stats.shortest_with_cycle_lambda,
+            expected.shortest_with_cycle_lambda);
+  EXPECT_EQ(stats.shortest_with_cycle, expected.shortest_with_cycle);
+}
+
+TEST(CheckpointTest, EmptyStatsRoundTrip) {
+  const Deck deck = {.colors = 2, .values = 3};
+  std::stringstream ss;
+  WriteStats(GameArena::Stats(deck), ss);
+  GameArena::Stats stats(deck);
+  ASSERT_TRUE(ReadStats(ss, stats));
+  EXPECT_EQ(stats.num_played, 0);
+  EXPECT_EQ(stats.longest_len, 0);
+  EXPECT_EQ(stats.shortest_with_cycle_len,
+            GameArena::Stats(deck).shortest_with_cycle_len);
+}
+
+TEST(CheckpointTest, SaveAndLoad) {
+  const Deck deck = {.colors = 4, .values = 3};
+  Checkpoint checkpoint(deck);
+  checkpoint.mode = "random";
+  checkpoint.strategy = Strategy::kOptimized;
+  checkpoint.seed = 42;
+  checkpoint.rng = Rng::kMt19937;
+  checkpoint.num_threads = 2;
+  checkpoint.elapsed = std::chrono::seconds(1234);
+  checkpoint.stats.num_played = 17;
+  checkpoint.estimates.Add({.winner = Game::Winner::kLeft, .num_steps = 1000});
+  checkpoint.estimates.Add({.winner = Game::Winner::kRight, .num_steps = 3});
+  checkpoint.estimates.Add(
+      {.winner = Game::Winner::kCycle, .num_steps = 6, .mu = 2, .lambda = 3});
+  checkpoint.remaining = {{.begin = 3, .end = 10}, {.begin = 12, .end = 20}};
+  checkpoint.thread_states = {"1 2 3", "4 5 6"};
+
+  const std::string path = testing::TempDir() + "/checkpoint_test.checkpoint";
+  ASSERT_TRUE(SaveCheckpoint(checkpoint, path));
+  const auto loaded = LoadCheckpoint(path);
+  std::remove(path.c_str());
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(loaded->mode, "random");
+  EXPECT_EQ(loaded->deck.colors, 4);
+  EXPECT_EQ(loaded->deck.values, 3);
+  EXPECT_EQ(loaded->strategy, Strategy::kOptimized);
+  EXPECT_EQ(loaded->seed, 42);
+  EXPECT_EQ(loaded->rng, Rng::kMt19937);
+  EXPECT_EQ(loaded->num_threads, 2);
+  EXPECT_EQ(loaded->elapsed, std::chrono::seconds(1234));
+  EXPECT_EQ(loaded->stats.num_played, 17);
+  EXPECT_EQ(loaded->estimates.num_winners, checkpoint.estimates.num_winners);
+  EXPECT_EQ(loaded->estimates.length_sum, 1003);
+  EXPECT_EQ(loaded->estimates.length_square_sum, 1000009);
+  EXPECT_EQ(loaded->estimates.length_histogram,
+            checkpoint.estimates.length_histogram);
+  ASSERT_EQ(loaded->remaining.size(), 2);
+  EXPECT_EQ(loaded->remaining[1].begin, 12);
+  EXPECT_EQ(loaded->remaining[1].end, 20);
+  EXPECT_EQ(loaded->thread_states, checkpoint.thread_states);
+}
+
+TEST(CheckpointTest, RejectsOtherVersions) {
+  const std::string path = testing::TempDir() + "/checkpoint_test_v2";
+  {
+    std::ofstream os(path);
+    os << "bataille-checkpoint 2\nmode random\ndeck 4 3\nstrategy natural\n"
+          "seed 42\nrng xoshiro256**\nthreads 1\nelapsed 12\n";
+    WriteStats(GameArena::Stats({.colors = 4, .values = 3}), os);
+    os << "remaining 0\nthread_states 1\n1 2 3\n";
+  }
+  EXPECT_FALSE(LoadCheckpoint(path));
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, LoadMissingFile) {
+  EXPECT_FALSE(LoadCheckpoint(testing::TempDir() + "/does_not_exist"));
+}
+
+}  // namespace
+}  // namespace bataille
@@ -0,0 +1,184 @@
+#include "deal_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace bataille {
+namespace {
+
+constexpr std::string_view kMagic = "BTLDEAL1";
+constexpr std::string_view kLeftKey = "cartes_joueur1=[";
+constexpr std::string_view kRightKey = "cartes_joueur2=[";
+
+void PutU32(uint32_t value, char* bytes) {
+  for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>(value >> (8 * i));
+}
+
+uint32_t GetU32(const char* bytes) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= uint32_t{static_cast<uint8_t>(bytes[i])} << (8 * i);
+  }
+  return value;
+}
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+}  // namespace
+
+void WriteDealFileHeader(Deck deck, std::ostream& os) {
+  std::array<char, kDealFileHeaderSize> header = {};
+  std::memcpy(header.data(), kMagic.data(), kMagic.size());
+  PutU32(deck.colors, header.data() + kMagic.size());
+  PutU32(deck.values, header.data() + kMagic.size() + 4);
+  os.write(header.data(), header.size());
+}
+
+void WriteDeal(std::span<const Card> cards, std::ostream& os) {
+  os.write(reinterpret_cast<const char*>(cards.data()), cards.size());
+}
+
+std::optional<MappedDealFile> MappedDealFile::Open(const std::string& path,
+                                                   Deck deck,
+                                                   std::string& error) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    if (fd >= 0) close(fd);
+    error = "cannot open " + path;
+    return std::nullopt;
+  }
+  const size_t size = st.st_size;
+  // Empty files cannot be mapped, and have no deals.
+  if (size == 0) {
+    close(fd);
+    return MappedDealFile(nullptr, 0, deck, /*binary=*/false);
+  }
+  void* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    error = "cannot map " + path;
+    return std::nullopt;
+  }
+  const auto* const bytes = static_cast<const char*>(data);
+  const bool binary = size >= kDealFileHeaderSize &&
+                      std::memcmp(bytes, kMagic.data(), kMagic.size()) == 0;
+  if (binary && (GetU32(bytes + kMagic.size()) != deck.colors ||
+                 GetU32(bytes + kMagic.size() + 4) != deck.values)) {
+    munmap(data, size);
+    error = path + " has the deals of another deck";
+    return std::nullopt;
+  }
+  // Deals are read once, in order.
+  madvise(data, size, MADV_SEQUENTIAL);
+  return MappedDealFile(bytes, size, deck, binary);
+}
+
+MappedDealFile::MappedDealFile(const char* data, size_t size, Deck deck,
+                               bool binary)
+    : data_(data),
+      size_(size),
+      deck_(deck),
+      binary_(binary),
+      pos_(binary ? kDealFileHeaderSize : 0) {}
+
+MappedDealFile::MappedDealFile(MappedDealFile&& other)
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(other.size_),
+      deck_(other.deck_),
+      binary_(other.binary_),
+      pos_(other.pos_),
+      num_read_(other.num_read_),
+      error_(std::move(other.error_)) {}
+
+MappedDealFile::~MappedDealFile() {
+  if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+}
+
+bool MappedDealFile::Next(std::span<Card> cards) {
+  if (!error_.empty()) return false;
+  const size_t num_cards = cards.size();
+  if (binary_) {
+    if (pos_ == size_) return false;
+    if (size_ - pos_ < num_cards) return Fail("truncated deal");
+    std::memcpy(cards.data(), data_ + pos_, num_cards);
+    pos_ += num_cards;
+  } else {
+    const std::string_view text(data_ == nullptr ? "" : data_, size_);
+    const size_t left = text.find(kLeftKey, pos_);
+    if (left == std::string_view::npos) {
+      pos_ = size_;
+      return false;
+    }
+    pos_ = left + kLeftKey.size();
+    const auto num_left = ParseCards(kLeftKey, cards);
+    if (!num_left) return false;
+    while (pos_ < size_ && IsSpace(data_[pos_])) ++pos_;
+    if (!text.substr(pos_).starts_with(kRightKey)) {
+      return Fail("expected cartes_joueur2 after cartes_joueur1");
+    }
+    pos_ += kRightKey.size();
+    const auto num_right = ParseCards(kRightKey, cards.subspan(*num_left));
+    if (!num_right) return false;
+    if (*num_left + *num_right != num_cards) {
+      return Fail("wrong number of cards");
+    }
+    if (*num_left != num_cards / 2) {
+      return Fail("cartes_joueur1 must have the first half of the cards");
+    }
+  }
+  // Each value must appear once per color.
+  std::array<unsigned, 256> counts = {};
+  for (const Card card : cards) {
+    if (card < 1 || card > deck_.values || ++counts[card] > deck_.colors) {
+      return Fail("not a deal of the deck");
+    }
+  }
+  ++num_read_;
+  return true;
+}
+
+std::optional<size_t> MappedDealFile::ParseCards(std::string_view key,
+                                                 std::span<Card> cards) {
+  size_t num_cards = 0;
+  while (true) {
+    while (pos_ < size_ && IsSpace(data_[pos_])) ++pos_;
+    if (pos_ < size_ && data_[pos_] == ']') {
+      ++pos_;
+      return num_cards;
+    }
+    unsigned value = 0;
+    const size_t start = pos_;
+    while (pos_ < size_ && data_[pos_] >= '0' && data_[pos_] <= '9' &&
+           value <= deck_.values) {
+      value = value * 10 + (data_[pos_++] - '0');
+    }
+    if (pos_ == start || num_cards == cards.size() || value > deck_.values) {
+      Fail("invalid " + std::string(key.substr(0, key.size() - 2)));
+      return std::nullopt;
+    }
+    cards[num_cards++] = value;
+    while (pos_ < size_ && IsSpace(data_[pos_])) ++pos_;
+    if (pos_ < size_ && data_[pos_] == ',') ++pos_;
+  }
+}
+
+bool MappedDealFile::Fail(const std::string& reason) {
+  error_ = "deal " + std::to_string(num_read_) + ": " + reason;
+  return false;
+}
+
+}  // namespace bataille
@@ -0,0 +1,83 @@
+#ifndef DEAL_FILE_H
+#define DEAL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "bataille.h"
+
+namespace bataille {
+
+// A deal file is a list of deals to evaluate, in one of two forms.
+//
+// Binary: a header of `kDealFileHeaderSize` bytes, with the magic "BTLDEAL1"
+// then the colors and values as 32-bit little endian integers, then zeros,
+// followed by the deals, one byte per card.
+//
+// Text: any text where each deal is written as in the results files, a
+// `cartes_joueur1=[...]` list with the cards of the left player, then a
+// `cartes_joueur2=[...]` list with those of the right player, cards being
+// separated (and optionally followed) by commas. Anything else is ignored, so
+// results files are deal files of their records.
+//
+// In both forms, the left player has the first half of the cards, as dealt
+// by `Game::Deal`.
+
+constexpr size_t kDealFileHeaderSize = 32;
+
+// Writes the header of a binary deal file of `deck`. Deals follow as their
+// cards, see `WriteDeal`.
+void WriteDealFileHeader(Deck deck, std::ostream& os);
+void WriteDeal(std::span<const Card> cards, std::ostream& os);
+
+// A deal file mapped in memory, whose deals are read in order, parsed in
+// place.
+class MappedDealFile {
+ public:
+  // Returns std::nullopt, with the reason in `error`, if `path` cannot be
+  // mapped, or is a binary file for another deck.
+  static std::optional<MappedDealFile> Open(const std::string& path,
+                                            Deck deck, std::string& error);
+
+  MappedDealFile(MappedDealFile&& other);
+  MappedDealFile& operator=(MappedDealFile&&) = delete;
+  ~MappedDealFile();
+
+  bool binary() const { return binary_; }
+  // The number of deals read so far.
+  uint64_t num_read() const { return num_read_; }
+
+  // Reads the next deal into `cards`, which has `deck.num_cards()` cards.
+  // Returns false at the end of the file, or if the deal is not a deal of
+  // the deck, with the reason in `error()`.
+  bool Next(std::span<Card> cards);
+  // Empty unless `Next` found an invalid deal.
+  const std::string& error() const { return error_; }
+
+ private:
+  MappedDealFile(const char* data, size_t size, Deck deck, bool binary);
+
+  // Parses the list of cards after `key` (a text deal). Returns the number of
+  // cards, or std::nullopt if the list is invalid or there are more than
+  // `cards.size()` cards.
+  std::optional<size_t> ParseCards(std::string_view key, std::span<Card> cards);
+  bool Fail(const std::string& reason);
+
+  const char* data_;
+  size_t size_;
+  const Deck deck_;
+  const bool binary_;
+  // The next byte to read.
+  size_t pos_;
+  uint64_t num_read_ = 0;
+  std::string error_;
+};
+
+}  // namespace bataille
+
+#endif  // DEAL_FILE_H
@@ -0,0 +1,137 @@
+#include "deal_file.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+// Writes `contents` to a temporary file and returns its path.
+std::string WriteFile(const std::string& name, const std::string& contents) {
+  const std::string path = testing::TempDir() + "/" + name;
+  std::ofstream(path, std::ios::binary) << contents;
+  return path;
+}
+
+// Returns the deals of the file at `path`, which is removed, and the error
+// of the file after the last deal.
+std::vector<std::vector<Card>> ReadDeals(const std::string& path, Deck deck,
+                                         std::string& error) {
+  auto file = MappedDealFile::Open(path, deck, error);
+  std::remove(path.c_str());
+  if (!file) return {};
+  std::vector<std::vector<Card>> deals;
+  std::vector<Card> cards(deck.num_cards());
+  while (file->Next(cards)) deals.push_back(cards);
+  EXPECT_EQ(file->num_read(), deals.size());
+  error = file->error();
+  return deals;
+}
+
+TEST(DealFileTest, Binary) {
+  const Deck deck = {.colors = 2, .values = 3};
+  const std::vector<std::vector<Card>> deals = {{1, 1, 2, 2, 3, 3},
+                                                {3, 2, 1, 3, 2, 1}};
+  std::ostringstream os;
+  WriteDealFileHeader(deck, os);
+  for (const auto& deal : deals) WriteDeal(deal, os);
+  const std::string path = WriteFile("deals.bin", os.str());
+  std::string error;
+  EXPECT_TRUE(MappedDealFile::Open(path, deck, error)->binary());
+  EXPECT_EQ(ReadDeals(path, deck, error), deals);
+  EXPECT_EQ(error, "");
+}
+
+TEST(DealFileTest, BinaryErrors) {
+  std::ostringstream os;
+  WriteDealFileHeader({.colors = 1, .values = 4}, os);
+  WriteDeal(std::vector<Card>{4, 3, 2, 1}, os);
+  std::string error;
+  const std::string path = WriteFile("errors.bin", os.str());
+  EXPECT_FALSE(MappedDealFile::Open(path, {.colors = 2, .values = 2}, error));
+  EXPECT_EQ(error, path + " has the deals of another deck");
+
+  WriteDeal(std::vector<Card>{4, 3, 2, 2}, os);
+  EXPECT_EQ(ReadDeals(WriteFile("errors.bin", os.str()),
+                      {.colors = 1, .values = 4}, error)
+                .size(),
+            1);
+  EXPECT_EQ(error, "deal 1: not a deal of the deck");
+
+  std::ostringstream truncated;
+  WriteDealFileHeader({.colors = 1, .values = 4}, truncated);
+  truncated << "\x01\x02";
+  EXPECT_TRUE(ReadDeals(WriteFile("truncated.bin", truncated.str()),
+                        {.colors = 1, .values = 4}, error)
+                  .empty());
+  EXPECT_EQ(error, "deal 0: truncated deal");
+}
+
+TEST(DealFileTest, ResultsFile) {
+  const std::string path = WriteFile(
+      "c1v10.txt",
+      "exhaustive exploration C=1 V=10\n\n"
+      "119964 loops found after 1048576/1.8144e+06\n"
+      "shortest game with cycle (60):\n"
+      "cartes_joueur1=[1,2,3,4,9,]\n"
+      "cartes_joueur2=[5,6,10,7,8,]\n"
+      "longest game (49):\n"
+      "cartes_joueur1=[1, 6, 2, 3, 9]\n"
+      "cartes_joueur2=[ 4,5,7,10,8 ]\n"
+      "time: 1s\n");
+  std::string error;
+  const std::vector<std::vector<Card>> expected = {
+      {1, 2, 3, 4, 9, 5, 6, 10, 7, 8}, {1, 6, 2, 3, 9, 4, 5, 7, 10, 8}};
+  EXPECT_EQ(ReadDeals(path, {.colors = 1, .values = 10}, error), expected);
+  EXPECT_EQ(error, "");
+}
+
+TEST(DealFileTest, TextErrors) {
+  const Deck deck = {.colors = 1, .values = 4};
+  for (const auto& [text, expected_error] :
+       std::vector<std::pair<std::string, std::string>>{
+           {"cartes_joueur1=[1,2,]\n", "deal 0: expected cartes_joueur2 after"
+                                       " cartes_joueur1"},
+           {"cartes_joueur1=[1,2,]\ncartes_joueur2=[3,]",
+            "deal 0: wrong number of cards"},
+           {"cartes_joueur1=[1,2,]\ncartes_joueur2=[3,5]",
+            "deal 0: invalid cartes_joueur2"},
+           {"cartes_joueur1=[1,2,x]\ncartes_joueur2=[3,4]",
+            "deal 0: invalid cartes_joueur1"},
+           {"cartes_joueur1=[1,2,3,4,1]\ncartes_joueur2=[]",
+            "deal 0: invalid cartes_joueur1"},
+           {"cartes_joueur1=[1,2,3]\ncartes_joueur2=[4]",
+            "deal 0: cartes_joueur1 must have the first half of the cards"},
+           {"cartes_joueur1=[1,2,3,4]\ncartes_joueur2=[4,1]",
+            "deal 0: invalid cartes_joueur2"},
+           {"cartes_joueur1=[1,2]\ncartes_joueur2=[1,4]",
+            "deal 0: not a deal of the deck"},
+       }) {
+    std::string error;
+    EXPECT_TRUE(ReadDeals(WriteFile("errors.txt", text), deck, error).empty())
+        << text;
+    EXPECT_EQ(error, expected_error) << text;
+  }
+}
+
+TEST(DealFileTest, Empty) {
+  std::string error;
+  EXPECT_TRUE(
+      ReadDeals(WriteFile("empty.txt", ""), {.colors = 1, .values = 4}, error)
+          .empty());
+  EXPECT_EQ(error, "");
+  EXPECT_TRUE(MappedDealFile::Open(testing::TempDir() + "/does_not_exist",
+                                   {.colors = 1, .values = 4}, error) ==
+              std::nullopt);
+  EXPECT_EQ(error, "cannot open " + testing::TempDir() + "/does_not_exist");
+}
+
+}  // namespace
+}  // namespace bataille
@@ -0,0 +1,226 @@
+#include "engine.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "fixed_game.h"
+#include "instrument.h"
+
+namespace bataille {
+namespace {
+
+// States are looked up in the outcome cache when the tortoise teleports
+// (after 2^k - 1 steps), between these depths.
+constexpr unsigned kMinProbeSteps = 7;
+constexpr unsigned kMaxProbeSteps = 63;
+constexpr unsigned kMaxProbes = 4;
+
+// `GameT` has the interface of `Game`, and is copy-assignable.
+template <typename GameT>
+class CycleDetectingEngine final : public Engine {
+ public:
+  explicit CycleDetectingEngine(Deck deck) : tortoise_(deck), hare_(deck) {}
+
+  Game::Result Play(std::span<const Card> cards, Strategy strategy) override {
+    num_probes_ = 0;
+    const Game::Result result = Run(cards, strategy);
+    if (cache_ != nullptr) Remember(result);
+    return result;
+  }
+
+  void SetCache(OutcomeCache* cache,
+                GameArena::Stats::CacheCounters* counters) override {
+    cache_ = cache;
+    counters_ = counters;
+  }
+
+ private:
+  Game::Result Run(std::span<const Card> cards, Strategy strategy) {
+    // Cycle detection uses Brent's method: the hare plays the game, and the
+    // tortoise teleports to the hare every power of two steps. This is about
+    // one `Step` per round, plus a comparison.
+    tortoise_.Deal(cards);
+    hare_.Deal(cards);
+    BATAILLE_COUNT(Rounds(1));
+    if (hare_.Step(strategy))
+      return {.winner = hare_.GetWinner(), .num_steps = 1};
+    unsigned steps = 1;
+    unsigned power = 1;
+    unsigned lambda = 1;
+    while (tortoise_ != hare_) {
+      if (power == lambda) {
+        if (cache_ != nullptr && steps >= kMinProbeSteps &&
+            steps <= kMaxProbeSteps) {
+          if (const auto outcome = Probe(steps, strategy)) {
+            if (outcome->winner != Game::Winner::kCycle) {
+              return {.winner = outcome->winner,
+                      .num_steps = steps + outcome->num_steps};
+            }
+            return Cycle(cards, strategy, outcome->num_steps);
+          }
+        }
+        tortoise_ = hare_;
+        power *= 2;
+        lambda = 0;
+      }
+      // Play until the tortoise teleports, or the hare meets it.
+      unsigned num_rounds;
+      const bool over =
+          hare_.Step(strategy, power - lambda, &tortoise_, num_rounds);
+      BATAILLE_COUNT(Rounds(num_rounds));
+      steps += num_rounds;
+      if (over) return {.winner = hare_.GetWinner(), .num_steps = steps};
+      lambda += num_rounds;
+    }
+    BATAILLE_COUNT(collision_steps.Add(steps));
+    return Cycle(cards, strategy, lambda);
+  }
+
+  // Returns the result of a game that cycles with period `lambda`.
+  Game::Result Cycle(std::span<const Card> cards, Strategy strategy,
+                     unsigned lambda) {
+    BATAILLE_COUNT(cycle_periods.Add(lambda));
+    // With the hare `lambda` steps ahead of the tortoise, their first meeting
+    // point is the start of the cycle.
+    tortoise_.Deal(cards);
+    hare_.Deal(cards);
+    for (unsigned i = 0; i < lambda;) {
+      unsigned num_rounds;
+      hare_.Step(strategy, lambda - i, nullptr, num_rounds);
+      BATAILLE_COUNT(Rounds(num_rounds));
+      i += num_rounds;
+    }
+    unsigned mu = 0;
+    while (tortoise_ != hare_) {
+      tortoise_.Step(strategy);
+      hare_.Step(strategy);
+      BATAILLE_COUNT(Rounds(2));
+      ++mu;
+    }
+    return {.winner = Game::Winner::kCycle,
+            .num_steps = (mu / lambda + 1) * lambda,
+            .mu = mu,
+            .lambda = lambda};
+  }
+
+  // Looks up the current state of the hare, which is `steps` rounds into the
+  // game. On a miss, the state is remembered for `Remember`.
+  std::optional<OutcomeCache::Outcome> Probe(unsigned steps,
+                                             Strategy strategy) {
+    StateKey key = hare_.Key();
+    key.Add(static_cast<uint64_t>(strategy));
+    ++counters_->lookups;
+    const auto outcome = cache_->Lookup(key);
+    if (outcome) {
+      ++counters_->hits;
+    } else if (num_probes_ < kMaxProbes) {
+      probes_[num_probes_++] = {key, steps};
+    }
+    return outcome;
+  }
+
+  // Stores the outcome of the states that missed the cache.
+  void Remember(const Game::Result& result) {
+    for (unsigned i = 0; i < num_probes_; ++i) {
+      const auto& [key, steps] = probes_[i];
+      if (result.winner == Game::Winner::kCycle) {
+        cache_->Insert(key, {.winner = Game::Winner::kCycle,
+                             .num_steps = result.lambda});
+      } else {
+        cache_->Insert(key, {.winner = result.winner,
+                             .num_steps = result.num_steps - steps});
+      }
+    }
+  }
+
+  GameT tortoise_;
+  GameT hare_;
+  OutcomeCache* cache_ = nullptr;
+  GameArena::Stats::CacheCounters* counters_ = nullptr;
+  std::array<std::pair<StateKey, unsigned>, kMaxProbes> probes_;
+  unsigned num_probes_ = 0;
+};
+
+// Plays games of a deck known at compile time (see `FixedGame`).
+template <unsigned kColors, unsigned kValues>
+class FixedEngine final : public Engine {
+ public:
+  FixedEngine() : natural_(kDeck), optimized_(kDeck) {}
+
+  Game::Result Play(std::span<const Card> cards, Strategy strategy) override {
+    return strategy == Strategy::kNatural ? natural_.Play(cards, strategy)
+                                          : optimized_.Play(cards, strategy);
+  }
+
+  void SetCache(OutcomeCache* cache,
+                GameArena::Stats::CacheCounters* counters) override {
+    natural_.SetCache(cache, counters);
+    optimized_.SetCache(cache, counters);
+  }
+
+ private:
+  static constexpr Deck kDeck = {.colors = kColors, .values = kValues};
+
+  CycleDetectingEngine<FixedGame<kColors, kValues, Strategy::kNatural>>
+      natural_;
+  CycleDetectingEngine<FixedGame<kColors, kValues, Strategy::kOptimized>>
+      optimized_;
+};
+
+// Fixed engines are compiled for these decks.
+constexpr unsigned kMaxFixedColors = 4;
+constexpr unsigned kMaxFixedValues = 13;
+
+using EngineFactory = std::unique_ptr<Engine> (*)();
+
+template <unsigned kColors, unsigned kValues>
+std::unique_ptr<Engine> MakeFixed() {
+  if constexpr (kColors * kValues < 2) {
+    return nullptr;
+  } else {
+    return std::make_unique<FixedEngine<kColors, kValues>>();
+  }
+}
+
+template <unsigned kColors, unsigned... kValuesMinusOne>
+constexpr std::array<EngineFactory, kMaxFixedValues> FixedFactories(
+    std::integer_sequence<unsigned, kValuesMinusOne...>) {
+  return {&MakeFixed<kColors, kValuesMinusOne + 1>...};
+}
+
+template <unsigned... kColorsMinusOne>
+constexpr std::array<std::array<EngineFactory, kMaxFixedValues>,
+                     kMaxFixedColors>
+FixedFactoryTable(std::integer_sequence<unsigned, kColorsMinusOne...>) {
+  return {FixedFactories<kColorsMinusOne + 1>(
+      std::make_integer_sequence<unsigned, kMaxFixedValues>())...};
+}
+
+// `kFixedFactories[c - 1][v - 1]` makes the engine for `c` colors and `v`
+// values.
+constexpr auto kFixedFactories = FixedFactoryTable(
+    std::make_integer_sequence<unsigned, kMaxFixedColors>());
+
+}  // namespace
+
+std::unique_ptr<Engine> MakeGenericEngine(Deck deck) {
+  return std::make_unique<CycleDetectingEngine<Game>>(deck);
+}
+
+std::unique_ptr<Engine> MakeFixedEngine(Deck deck) {
+  if (deck.colors < 1 || deck.colors > kMaxFixedColors || deck.values < 1 ||
+      deck.values > kMaxFixedValues) {
+    return nullptr;
+  }
+  return kFixedFactories[deck.colors - 1][deck.values - 1]();
+}
+
+std::unique_ptr<Engine> MakeEngine(Deck deck) {
+  if (auto engine = MakeFixedEngine(deck)) return engine;
+  return MakeGenericEngine(deck);
+}
+
+}  // namespace bataille
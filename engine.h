@@ -0,0 +1,41 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <memory>
+#include <span>
+
+#include "bataille.h"
+#include "outcome_cache.h"
+
+namespace bataille {
+
+// Plays a game until the end or until a cycle is found. Implementations differ
+// by their representation of games.
+class Engine {
+ public:
+  virtual ~Engine() = default;
+
+  // See `GameArena::Play`. Precondition: there are at least two cards.
+  virtual Game::Result Play(std::span<const Card> cards,
+                            Strategy strategy) = 0;
+
+  // Makes the engine look up and remember intermediate states in `cache`
+  // (which may be null), counting lookups in `counters`.
+  virtual void SetCache(OutcomeCache* cache,
+                        GameArena::Stats::CacheCounters* counters) = 0;
+};
+
+// Returns an engine using `Game`.
+std::unique_ptr<Engine> MakeGenericEngine(Deck deck);
+
+// Returns an engine using `FixedGame`, or null if `deck` is not one of the
+// decks it is compiled for (1 to 4 colors, up to 13 values).
+std::unique_ptr<Engine> MakeFixedEngine(Deck deck);
+
+// Returns the fastest engine for `deck`: a `FixedGame` engine for common decks,
+// otherwise a `Game` engine.
+std::unique_ptr<Engine> MakeEngine(Deck deck);
+
+}  // namespace bataille
+
+#endif  // ENGINE_H
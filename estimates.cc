@@ -0,0 +1,176 @@
+#include "estimates.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+// For 95% confidence intervals.
+constexpr double kZ = 1.96;
+
+// Returns the half width of the interval of a probability estimated from
+// `num_samples` samples, for a probability `p`, with the normal
+// approximation.
+double NormalHalfWidth(double p, uint64_t num_samples) {
+  return kZ * std::sqrt(p * (1 - p) / num_samples);
+}
+
+// Returns the bucket of the game at `rank` (from 1, the shortest game) in
+// `histogram`.
+unsigned BucketAtRank(const std::vector<uint64_t>& histogram, uint64_t rank) {
+  uint64_t num_games = 0;
+  for (unsigned bucket = 0; bucket < histogram.size(); ++bucket) {
+    num_games += histogram[bucket];
+    if (num_games >= rank) return bucket;
+  }
+  assert(false);
+  return 0;
+}
+
+void PrintInterval(const GameEstimates::Interval& interval, std::ostream& os) {
+  os << interval.estimate << " [" << interval.low << ", " << interval.high
+     << "]\n";
+}
+
+}  // namespace
+
+unsigned LengthBucket(unsigned num_steps) {
+  constexpr unsigned kSub = GameEstimates::kExactLengths;
+  if (num_steps < kSub) return num_steps;
+  // The 7 bits below the most significant one select one of 128 buckets.
+  const unsigned shift = std::bit_width(num_steps) - std::bit_width(kSub);
+  return kSub + shift * kSub + ((num_steps >> shift) - kSub);
+}
+
+std::pair<unsigned, unsigned> LengthBucketRange(unsigned bucket) {
+  constexpr unsigned kSub = GameEstimates::kExactLengths;
+  if (bucket < kSub) return {bucket, bucket};
+  const unsigned shift = (bucket - kSub) / kSub;
+  const unsigned low = (kSub + (bucket - kSub) % kSub) << shift;
+  return {low, low + (1u << shift) - 1};
+}
+
+void GameEstimates::Add(const Game::Result& result) {
+  ++num_winners[static_cast<unsigned>(result.winner)];
+  if (result.winner == Game::Winner::kCycle) return;
+  length_sum += result.num_steps;
+  length_square_sum += static_cast<double>(result.num_steps) * result.num_steps;
+  const unsigned bucket = LengthBucket(result.num_steps);
+  if (bucket >= length_histogram.size()) length_histogram.resize(bucket + 1);
+  ++length_histogram[bucket];
+}
+
+void GameEstimates::Merge(const GameEstimates& other) {
+  for (size_t i = 0; i < num_winners.size(); ++i) {
+    num_winners[i] += other.num_winners[i];
+  }
+  length_sum += other.length_sum;
+  length_square_sum += other.length_square_sum;
+  if (other.length_histogram.size() > length_histogram.size()) {
+    length_histogram.resize(other.length_histogram.size());
+  }
+  for (size_t i = 0; i < other.length_histogram.size(); ++i) {
+    length_histogram[i] += other.length_histogram[i];
+  }
+}
+
+uint64_t GameEstimates::num_games() const {
+  return num_ended() +
+         num_winners[static_cast<unsigned>(Game::Winner::kCycle)];
+}
+
+uint64_t GameEstimates::num_ended() const {
+  return num_winners[static_cast<unsigned>(Game::Winner::kLeft)] +
+         num_winners[static_cast<unsigned>(Game::Winner::kRight)] +
+         num_winners[static_cast<unsigned>(Game::Winner::kDraw)];
+}
+
+GameEstimates::Interval GameEstimates::Probability(
+    Game::Winner winner) const {
+  const double n = num_games();
+  if (n == 0) return {0, 0, 1};
+  const double p = num_winners[static_cast<unsigned>(winner)] / n;
+  const double z2 = kZ * kZ;
+  const double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+  const double half_width =
+      kZ * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+  return {p, std::max(0.0, center - half_width),
+          std::min(1.0, center + half_width)};
+}
+
+GameEstimates::Interval GameEstimates::MeanLength() const {
+  const uint64_t n = num_ended();
+  if (n == 0) return {0, 0, 0};
+  const double mean = static_cast<double>(length_sum) / n;
+  const double variance =
+      n < 2 ? 0
+            : std::max(0.0, (length_square_sum - n * mean * mean) / (n - 1));
+  const double half_width = kZ * std::sqrt(variance / n);
+  return {mean, mean - half_width, mean + half_width};
+}
+
+GameEstimates::Interval GameEstimates::LengthQuantile(double q) const {
+  const uint64_t n = num_ended();
+  if (n == 0) return {0, 0, 0};
+  const auto rank = [&](double r) {
+    return static_cast<uint64_t>(
+        std::clamp(std::ceil(r), 1.0, static_cast<double>(n)));
+  };
+  const double half_width = n * NormalHalfWidth(q, n);
+  const uint64_t ranks[] = {rank(q * n), rank(q * n - half_width),
+                            rank(q * n + half_width)};
+  unsigned buckets[std::size(ranks)];
+  for (size_t i = 0; i < std::size(ranks); ++i) {
+    buckets[i] = BucketAtRank(length_histogram, ranks[i]);
+  }
+  const auto [low, high] = LengthBucketRange(buckets[0]);
+  return {(low + high) / 2.0,
+          static_cast<double>(LengthBucketRange(buckets[1]).first),
+          static_cast<double>(LengthBucketRange(buckets[2]).second)};
+}
+
+bool GameEstimates::Reached(double precision) const {
+  if (num_games() < kMinGames) return false;
+  for (const Game::Winner winner :
+       {Game::Winner::kLeft, Game::Winner::kRight, Game::Winner::kDraw,
+        Game::Winner::kCycle}) {
+    const Interval p = Probability(winner);
+    if (p.high - p.estimate > precision || p.estimate - p.low > precision) {
+      return false;
+    }
+  }
+  const uint64_t n = num_ended();
+  if (n == 0) return true;
+  for (const double q : kQuantiles) {
+    if (NormalHalfWidth(q, n) > precision) return false;
+  }
+  const Interval mean = MeanLength();
+  return mean.high - mean.estimate <= precision * mean.estimate;
+}
+
+void GameEstimates::Print(std::ostream& os) const {
+  os << "estimates after " << num_games() << " games (95% confidence):\n";
+  os << "left wins: ";
+  PrintInterval(Probability(Game::Winner::kLeft), os);
+  os << "right wins: ";
+  PrintInterval(Probability(Game::Winner::kRight), os);
+  os << "draws: ";
+  PrintInterval(Probability(Game::Winner::kDraw), os);
+  os << "cycles: ";
+  PrintInterval(Probability(Game::Winner::kCycle), os);
+  os << "mean length: ";
+  PrintInterval(MeanLength(), os);
+  for (const double q : kQuantiles) {
+    os << "length quantile " << q << ": ";
+    PrintInterval(LengthQuantile(q), os);
+  }
+}
+
+}  // namespace bataille
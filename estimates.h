@@ -0,0 +1,77 @@
+#ifndef ESTIMATES_H
+#define ESTIMATES_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "bataille.h"
+
+namespace bataille {
+
+// Running estimates of the outcomes of random games, with 95% confidence
+// intervals: the probability of each winner (and of cycles), and the mean and
+// quantiles of the length of games that end. Estimates only keep counts, so
+// the estimates of several threads merge into the estimates of all their
+// games.
+//
+// Lengths are counted in a log-linear histogram: exactly up to
+// `kExactLengths`, then in buckets whose width is 1/128 of their lower bound,
+// so quantiles are known within 0.8%.
+struct GameEstimates {
+  // The quantiles of the length of games that are estimated.
+  static constexpr std::array<double, 3> kQuantiles = {0.5, 0.9, 0.99};
+  static constexpr unsigned kExactLengths = 128;
+  // Intervals are not trusted with fewer games.
+  static constexpr uint64_t kMinGames = 100;
+
+  struct Interval {
+    double estimate;
+    double low;
+    double high;
+  };
+
+  void Add(const Game::Result& result);
+  void Merge(const GameEstimates& other);
+
+  uint64_t num_games() const;
+  // Games that end, without a cycle.
+  uint64_t num_ended() const;
+
+  // The probability that a game ends with `winner` (`kCycle` for a cycle),
+  // with a Wilson score interval.
+  Interval Probability(Game::Winner winner) const;
+  // The mean length of games that end, with a normal interval.
+  Interval MeanLength() const;
+  // The `q`-quantile of the length of games that end. The interval is between
+  // the lengths at the ranks of the interval of the probability of being
+  // below the quantile, rounded out to histogram buckets.
+  Interval LengthQuantile(double q) const;
+
+  // Returns true if there are at least `kMinGames` games, the intervals of
+  // probabilities (of winners, and of being below each quantile) are within
+  // `precision` of their estimate, and the interval of the mean length is
+  // within `precision` times the mean.
+  bool Reached(double precision) const;
+
+  void Print(std::ostream& os) const;
+
+  // Counts of games by `Game::Winner`.
+  std::array<uint64_t, 4> num_winners = {};
+  // Sums of the lengths of games that end, and of their squares.
+  uint64_t length_sum = 0;
+  double length_square_sum = 0;
+  // Counts of games that end, by histogram bucket (see `LengthBucket`).
+  std::vector<uint64_t> length_histogram;
+};
+
+// Returns the histogram bucket of games of length `num_steps`.
+unsigned LengthBucket(unsigned num_steps);
+// Returns the smallest and largest lengths in `bucket`.
+std::pair<unsigned, unsigned> LengthBucketRange(unsigned bucket);
+
+}  // namespace bataille
+
+#endif  // ESTIMATES_H
@@ -0,0 +1,127 @@
+#include "estimates.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace bataille {
+namespace {
+
+using Winner = Game::Winner;
+
+TEST(EstimatesTest, LengthBuckets) {
+  for (unsigned n = 0; n < GameEstimates::kExactLengths; ++n) {
+    EXPECT_EQ(LengthBucket(n), n);
+  }
+  // Buckets follow each other, and are at most 1/128 of their lengths wide.
+  for (unsigned bucket = 0; bucket < 2000; ++bucket) {
+    const auto [low, high] = LengthBucketRange(bucket);
+    EXPECT_EQ(LengthBucket(low), bucket);
+    EXPECT_EQ(LengthBucket(high), bucket);
+    EXPECT_EQ(LengthBucketRange(bucket + 1).first, high + 1);
+    EXPECT_LE((high - low) * 128, low);
+  }
+  EXPECT_EQ(LengthBucketRange(LengthBucket(1000)),
+            std::pair(1000u, 1003u));
+}
+
+TEST(EstimatesTest, Probability) {
+  GameEstimates estimates;
+  for (int i = 0; i < 100; ++i) {
+    estimates.Add({.winner = i % 2 == 0 ? Winner::kLeft : Winner::kCycle,
+                   .num_steps = 10});
+  }
+  EXPECT_EQ(estimates.num_games(), 100);
+  EXPECT_EQ(estimates.num_ended(), 50);
+  const GameEstimates::Interval left = estimates.Probability(Winner::kLeft);
+  EXPECT_EQ(left.estimate, 0.5);
+  EXPECT_NEAR(left.low, 0.40383, 1e-5);
+  EXPECT_NEAR(left.high, 0.59617, 1e-5);
+  // The interval is not empty when no game has a winner.
+  const GameEstimates::Interval draws = estimates.Probability(Winner::kDraw);
+  EXPECT_EQ(draws.estimate, 0);
+  EXPECT_EQ(draws.low, 0);
+  EXPECT_NEAR(draws.high, 0.03699, 1e-5);
+}
+
+TEST(EstimatesTest, Lengths) {
+  GameEstimates estimates;
+  for (unsigned n = 1; n <= 100; ++n) {
+    estimates.Add({.winner = Winner::kRight, .num_steps = n});
+  }
+  // Cycles are not counted in lengths.
+  estimates.Add(
+      {.winner = Winner::kCycle, .num_steps = 600, .mu = 0, .lambda = 600});
+  const GameEstimates::Interval mean = estimates.MeanLength();
+  EXPECT_EQ(mean.estimate, 50.5);
+  EXPECT_NEAR(mean.high - mean.estimate, 5.6863, 1e-4);
+  EXPECT_NEAR(mean.estimate - mean.low, 5.6863, 1e-4);
+  const GameEstimates::Interval median = estimates.LengthQuantile(0.5);
+  EXPECT_EQ(median.estimate, 50);
+  EXPECT_EQ(median.low, 41);
+  EXPECT_EQ(median.high, 60);
+  const GameEstimates::Interval q99 = estimates.LengthQuantile(0.99);
+  EXPECT_EQ(q99.estimate, 99);
+  EXPECT_EQ(q99.low, 98);
+  EXPECT_EQ(q99.high, 100);
+
+  // Long games are in wider buckets.
+  estimates.Add({.winner = Winner::kLeft, .num_steps = 1000});
+  EXPECT_EQ(estimates.LengthQuantile(0.999).estimate, 1001.5);
+}
+
+TEST(EstimatesTest, Merge) {
+  GameEstimates all, even, odd;
+  for (unsigned n = 1; n <= 500; ++n) {
+    const Game::Result result = {
+        .winner = static_cast<Winner>(n % 4), .num_steps = n * 3};
+    all.Add(result);
+    (n % 2 == 0 ? even : odd).Add(result);
+  }
+  even.Merge(odd);
+  EXPECT_EQ(even.num_winners, all.num_winners);
+  EXPECT_EQ(even.length_sum, all.length_sum);
+  EXPECT_EQ(even.length_square_sum, all.length_square_sum);
+  EXPECT_EQ(even.length_histogram, all.length_histogram);
+}
+
+TEST(EstimatesTest, Reached) {
+  GameEstimates estimates;
+  // Too few games, even with the same outcome.
+  for (uint64_t i = 0; i + 1 < GameEstimates::kMinGames; ++i) {
+    estimates.Add({.winner = Winner::kLeft, .num_steps = 10});
+  }
+  EXPECT_FALSE(estimates.Reached(0.5));
+  estimates = {};
+
+  // The intervals of the probabilities are within 0.05 after about 400 games.
+  for (int i = 0; i < 300; ++i) {
+    estimates.Add({.winner = i % 2 == 0 ? Winner::kLeft : Winner::kRight,
+                   .num_steps = i % 2 == 0 ? 10u : 20u});
+  }
+  EXPECT_FALSE(estimates.Reached(0.05));
+  EXPECT_TRUE(estimates.Reached(0.1));
+  for (int i = 0; i < 100; ++i) {
+    estimates.Add({.winner = i % 2 == 0 ? Winner::kLeft : Winner::kRight,
+                   .num_steps = i % 2 == 0 ? 10u : 20u});
+  }
+  EXPECT_TRUE(estimates.Reached(0.05));
+}
+
+TEST(EstimatesTest, Print) {
+  GameEstimates estimates;
+  estimates.Add({.winner = Winner::kLeft, .num_steps = 4});
+  estimates.Add({.winner = Winner::kLeft, .num_steps = 4});
+  std::ostringstream os;
+  estimates.Print(os);
+  const std::string output = os.str();
+  EXPECT_EQ(output.find("estimates after 2 games (95% confidence):\n"), 0);
+  EXPECT_NE(output.find("\nmean length: 4 [4, 4]\n"), std::string::npos);
+  EXPECT_NE(output.find("\nlength quantile 0.9: 4 [4, 4]\n"),
+            std::string::npos);
+}
+
+}  // namespace
+}  // namespace bataille
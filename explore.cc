@@ -1,123 +1,1201 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <random>
+#include <span>
+#include <sstream>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "bataille.h"
+#include "checkpoint.h"
+#include "deal_file.h"
+#include "estimates.h"
+#include "game_log.h"
+#include "multiset.h"
+#include "outcome_cache.h"
+#include "progress.h"
+#include "rng.h"
+#include "search.h"
+#include "shard.h"
+#include "state_graph.h"
+#include "work_stealing.h"
 
 using bataille::Card;
+using bataille::Checkpoint;
 using bataille::Deck;
 using bataille::GameArena;
+using bataille::GameEstimates;
+using bataille::GameLogWriter;
+using bataille::MappedDealFile;
+using bataille::Rng;
+using bataille::SearchObjective;
 using bataille::Strategy;
 
-void Exhaustive(std::span<Card> cards, Strategy strategy, GameArena& arena,
-                std::ostream& os) {
+// Games are handed out to threads in chunks (of consecutive permutations in
+// exhaustive mode).
+constexpr uint64_t kChunkSize = 1 << 16;
+constexpr auto kDefaultReportInterval = std::chrono::seconds(1);
+constexpr auto kDefaultCheckpointInterval = std::chrono::minutes(10);
+
+// How the games of the same deals differ between the two strategies.
+struct StrategyComparison {
+  void Add(const bataille::Game::Result& natural,
+           const bataille::Game::Result& optimized) {
+    if (natural.winner != optimized.winner) {
+      ++num_different_winner;
+    } else if (natural.num_steps != optimized.num_steps) {
+      ++num_different_length;
+    } else {
+      ++num_same;
+    }
+  }
+
+  void Merge(const StrategyComparison& other) {
+    num_same += other.num_same;
+    num_different_winner += other.num_different_winner;
+    num_different_length += other.num_different_length;
+  }
+
+  void Print(std::ostream& os) const {
+    const uint64_t num_played =
+        num_same + num_different_winner + num_different_length;
+    const auto percent = [&](uint64_t n) {
+      return num_played == 0 ? 0.0 : 100.0 * n / num_played;
+    };
+    os << "same outcome with both strategies: " << num_same << " ("
+       << percent(num_same) << "%)\n"
+       << "different winner: " << num_different_winner << " ("
+       << percent(num_different_winner) << "%)\n"
+       << "same winner, different length: " << num_different_length << " ("
+       << percent(num_different_length) << "%)\n";
+  }
+
+  uint64_t num_same = 0;
+  uint64_t num_different_winner = 0;
+  uint64_t num_different_length = 0;
+};
+
+// A thread exploring games with its own arena. `mu` is held while the thread
+// fetches and plays a chunk of games, so that the reporting thread reads
+// consistent stats, and so that holding all mutexes stops the exploration in a
+// state that can be checkpointed.
+struct Worker {
+  Worker(Deck deck, bool both) : arena(deck), cards(deck.Make()) {
+    if (both) optimized.emplace(deck);
+  }
+
+  std::mutex mu;
+  GameArena arena;
+  // In `both` mode, `arena` plays the natural strategy, and this arena the
+  // optimized strategy on the same deals.
+  std::optional<GameArena> optimized;
+  StrategyComparison comparison;
+  // Random mode: the estimates of the games played by `arena`.
+  GameEstimates estimates;
+  // The number of games played by `arena`, updated after each chunk, for the
+  // reporting thread to read without waiting for the chunk to end.
+  std::atomic<uint64_t> num_played = 0;
+  // Random mode: the generator (only the one of the run is used), and the last
+  // deal, which is shuffled again to get the next one.
+  std::mt19937 mt19937;
+  bataille::Xoshiro256StarStar xoshiro;
+  std::vector<Card> cards;
+};
+
+// Deals waiting to be played with `GameArena::PlayBatch` (or
+// `PlayBatchBoth`).
+class DealBatch {
+ public:
+  static constexpr size_t kSize = 1024;
+
+  // Results are added to `log` and `estimates`, if not null.
+  DealBatch(Deck deck, GameLogWriter::Buffer* log, GameEstimates* estimates)
+      : results_(kSize),
+        optimized_results_(kSize),
+        log_(log),
+        estimates_(estimates) {
+    deals_.reserve(kSize * deck.num_cards());
+    indices_.reserve(kSize);
+  }
+
+  // Adds the deal `cards`, whose index in the game log is `index`. Returns
+  // true when the batch is full.
+  bool Add(std::span<const Card> cards, uint64_t index) {
+    deals_.insert(deals_.end(), cards.begin(), cards.end());
+    indices_.push_back(index);
+    return indices_.size() == kSize;
+  }
+
+  // Plays and clears the batch, with the arena of `worker`, or with both
+  // strategies if it has an `optimized` arena.
+  void Play(Worker& worker, Strategy strategy) {
+    const auto results = std::span(results_).first(indices_.size());
+    if (worker.optimized) {
+      const auto optimized_results =
+          std::span(optimized_results_).first(indices_.size());
+      worker.arena.PlayBatchBoth(deals_, results, optimized_results,
+                                 *worker.optimized);
+      for (size_t i = 0; i < results.size(); ++i) {
+        worker.comparison.Add(results[i], optimized_results[i]);
+      }
+    } else {
+      worker.arena.PlayBatch(deals_, results, strategy);
+    }
+    if (log_ != nullptr) {
+      for (size_t i = 0; i < results.size(); ++i) {
+        log_->Add(indices_[i], results[i]);
+      }
+    }
+    if (estimates_ != nullptr) {
+      for (const bataille::Game::Result& result : results) {
+        estimates_->Add(result);
+      }
+    }
+    deals_.clear();
+    indices_.clear();
+  }
+
+ private:
+  std::vector<Card> deals_;
+  std::vector<uint64_t> indices_;
+  std::vector<bataille::Game::Result> results_;
+  std::vector<bataille::Game::Result> optimized_results_;
+  GameLogWriter::Buffer* const log_;
+  GameEstimates* const estimates_;
+};
+
+// Returns the stats of `initial` (the checkpoint of the run before it was
+// resumed) merged with the stats of `workers`, and prints them to `os`,
+// followed by the estimates in random mode. In `both` mode, these are the
+// stats of the natural strategy, followed by those of the optimized strategy
+// and by how the games of both compare.
+GameArena::Stats PrintMergedStats(
+    const Checkpoint& initial,
+    const std::vector<std::unique_ptr<Worker>>& workers, std::ostream& os) {
+  GameArena::Stats stats = initial.stats;
+  GameArena::Stats optimized(initial.deck);
+  StrategyComparison comparison;
+  GameEstimates estimates = initial.estimates;
+  for (const auto& worker : workers) {
+    std::lock_guard<std::mutex> lock(worker->mu);
+    stats.Merge(worker->arena.stats());
+    estimates.Merge(worker->estimates);
+    if (worker->optimized) {
+      optimized.Merge(worker->optimized->stats());
+      comparison.Merge(worker->comparison);
+    }
+  }
+  if (!workers.front()->optimized) {
+    stats.Print(os);
+    if (estimates.num_games() > 0) estimates.Print(os);
+    return stats;
+  }
+  os << "natural:\n";
+  stats.Print(os);
+  os << "optimized:\n";
+  optimized.Print(os);
+  comparison.Print(os);
+  return stats;
+}
+
+// Returns `initial` merged with the estimates of `workers`.
+GameEstimates MergedEstimates(
+    const GameEstimates& initial,
+    const std::vector<std::unique_ptr<Worker>>& workers) {
+  GameEstimates estimates = initial;
+  for (const auto& worker : workers) {
+    std::lock_guard<std::mutex> lock(worker->mu);
+    estimates.Merge(worker->estimates);
+  }
+  return estimates;
+}
+
+// Returns the number of games played, including the `initial` ones, without
+// stopping the workers.
+uint64_t NumPlayed(uint64_t initial,
+                   const std::vector<std::unique_ptr<Worker>>& workers) {
+  uint64_t num_played = initial;
+  for (const auto& worker : workers) {
+    num_played += worker->num_played.load(std::memory_order_relaxed);
+  }
+  return num_played;
+}
+
+// Publishes the number of games played by `worker`, with its mutex held.
+void UpdateNumPlayed(Worker& worker) {
+  worker.num_played.store(worker.arena.stats().num_played,
+                          std::memory_order_relaxed);
+}
+
+std::chrono::seconds Elapsed(std::chrono::system_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now() - start);
+}
+
+// Tells the reporting loop that the workers are done.
+class DoneNotification {
+ public:
+  void Notify() {
+    std::lock_guard<std::mutex> lock(mu_);
+    done_ = true;
+    cv_.notify_all();
+  }
+
+  // Waits for at most `timeout`, returns true if notified.
+  bool WaitFor(std::chrono::seconds timeout) {
+    std::unique_lock<std::mutex> lock(mu_);
+    return cv_.wait_for(lock, timeout, [this] { return done_; });
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool done_ = false;
+};
+
+// Options shared by exploration modes.
+struct Options {
+  unsigned num_threads = 1;
+  // Whether to play the deals with both strategies, in one pass (see
+  // `GameArena::PlayBatchBoth`). The strategy of the mode is then ignored.
+  bool both = false;
+  std::chrono::seconds report_interval = kDefaultReportInterval;
+  // Where to write the progress as JSON lines (see `Progress::WriteJson`),
+  // null to disable it.
+  std::ostream* progress = nullptr;
+  // Size of the outcome cache, 0 to disable it.
+  size_t cache_mb = 0;
+  // Where to save checkpoints, empty to disable them.
+  std::string checkpoint_path;
+  std::chrono::seconds checkpoint_interval = kDefaultCheckpointInterval;
+  // Exhaustive mode: the shard to play (see `ShardRange`), and where to write
+  // its result, empty to play all deals without writing a shard result.
+  unsigned shard = 0;
+  unsigned num_shards = 1;
+  std::string shard_result_path;
+  // Where to write the result of every game, empty to disable the game log.
+  std::string log_path;
+  // Exhaustive mode: whether to solve the states of the deck first (see
+  // `StateGraph`), and look up the games there. This is slower than playing
+  // them, and only cross-checks the engines.
+  bool solve = false;
+  // Random mode: stop when the estimates reach this precision (see
+  // `GameEstimates::Reached`), 0 to never stop.
+  double precision = 0;
+};
+
+// Saves a checkpoint of the exploration. `checkpoint` has the fields that do
+// not change during the run, and the stats (and estimates) before the run was
+// resumed.
+// `add_state` adds the state of the mode to the checkpoint. It is called while
+// all workers are paused between two chunks, so that every game is either
+// counted in the stats or still to be played.
+void SaveCheckpoint(Checkpoint checkpoint,
+                    const std::vector<std::unique_ptr<Worker>>& workers,
+                    std::chrono::system_clock::time_point start,
+                    const std::function<void(Checkpoint&)>& add_state,
+                    const std::string& path) {
+  {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (const auto& worker : workers) locks.emplace_back(worker->mu);
+    for (const auto& worker : workers) {
+      checkpoint.stats.Merge(worker->arena.stats());
+      checkpoint.estimates.Merge(worker->estimates);
+    }
+    add_state(checkpoint);
+  }
+  checkpoint.elapsed = Elapsed(start);
+  if (!bataille::SaveCheckpoint(checkpoint, path)) {
+    std::cerr << "cannot save checkpoint to " << path << "\n";
+  }
+}
+
+// Every `options.report_interval`, until `done` is notified: reads the new
+// records of the arenas of `workers` from `records` (and of their `optimized`
+// arenas from `optimized_records`, in `both` mode), and when they improve the
+// records of the run, prints them to stdout and the merged stats of `workers`
+// to `os`. Writes the progress to `options.progress` (towards `num_games`, see
+// `Progress`), and saves checkpoints every `options.checkpoint_interval` (see
+// `SaveCheckpoint`). Workers are only stopped to print stats and save
+// checkpoints.
+void ReportUntilDone(const Checkpoint& checkpoint,
+                     const std::vector<std::unique_ptr<Worker>>& workers,
+                     GameArena::RecordQueue& records,
+                     GameArena::RecordQueue* optimized_records,
+                     double num_games,
+                     std::chrono::system_clock::time_point start,
+                     const Options& options,
+                     const std::function<void(Checkpoint&)>& add_state,
+                     DoneNotification& done, std::ostream& os) {
+  bataille::Progress progress(checkpoint.stats, num_games);
+  std::optional<bataille::Progress> optimized_progress;
+  if (optimized_records != nullptr) {
+    optimized_progress.emplace(GameArena::Stats(checkpoint.deck), num_games);
+  }
+  auto last_checkpoint = std::chrono::steady_clock::now();
+  const auto report = [&] {
+    const bool new_records = progress.Update(records);
+    const bool new_optimized_records =
+        optimized_progress && optimized_progress->Update(*optimized_records);
+    if (new_records || new_optimized_records) {
+      if (optimized_progress) std::cout << "natural:\n";
+      progress.PrintNewRecords(std::cout);
+      if (optimized_progress) {
+        std::cout << "optimized:\n";
+        optimized_progress->PrintNewRecords(std::cout);
+      }
+      PrintMergedStats(checkpoint, workers, os);
+      os << "time: " << Elapsed(start) << "\n";
+      os.flush();
+    }
+    if (options.progress != nullptr) {
+      progress.WriteJson(NumPlayed(checkpoint.stats.num_played, workers),
+                         std::chrono::system_clock::now() - start,
+                         *options.progress);
+      options.progress->flush();
+    }
+  };
+  while (!done.WaitFor(options.report_interval)) {
+    report();
+    if (!options.checkpoint_path.empty() &&
+        options.checkpoint_interval.count() > 0 &&
+        std::chrono::steady_clock::now() - last_checkpoint >=
+            options.checkpoint_interval) {
+      SaveCheckpoint(checkpoint, workers, start, add_state,
+                     options.checkpoint_path);
+      last_checkpoint = std::chrono::steady_clock::now();
+    }
+  }
+  report();
+}
+
+// Creates one worker per thread. The arenas of all workers share `cache`
+// (which may be null), and push their records to `records`. Workers have an
+// `optimized` arena if `optimized_records` is not null, where these arenas
+// push their records.
+std::vector<std::unique_ptr<Worker>> MakeWorkers(
+    Deck deck, const Options& options, bataille::OutcomeCache* cache,
+    GameArena::RecordQueue& records,
+    GameArena::RecordQueue* optimized_records) {
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (unsigned i = 0; i < options.num_threads; ++i) {
+    workers.push_back(
+        std::make_unique<Worker>(deck, optimized_records != nullptr));
+    Worker& worker = *workers.back();
+    if (cache != nullptr) worker.arena.SetOutcomeCache(cache);
+    worker.arena.SetRecordQueue(&records);
+    if (worker.optimized) {
+      if (cache != nullptr) worker.optimized->SetOutcomeCache(cache);
+      worker.optimized->SetRecordQueue(optimized_records);
+    }
+  }
+  return workers;
+}
+
+std::unique_ptr<bataille::OutcomeCache> MakeCache(const Options& options) {
+  if (options.cache_mb == 0) return nullptr;
+  return std::make_unique<bataille::OutcomeCache>(options.cache_mb << 20);
+}
+
+// Returns the writer of the game log, or null if there is none or if it cannot
+// be written (which is printed).
+std::unique_ptr<GameLogWriter> MakeGameLog(
+    const bataille::GameLogHeader& header, const Options& options) {
+  if (options.log_path.empty()) return nullptr;
+  auto log = std::make_unique<GameLogWriter>(options.log_path, header);
+  if (!log->ok()) {
+    std::cerr << "cannot write " << options.log_path << "\n";
+    return nullptr;
+  }
+  return log;
+}
+
+// Returns the buffer of a thread for `log`, which may be null.
+std::optional<GameLogWriter::Buffer> MakeGameLogBuffer(GameLogWriter* log) {
+  if (log == nullptr) return std::nullopt;
+  return std::optional<GameLogWriter::Buffer>(std::in_place, *log);
+}
+
+// `resumed` is the checkpoint to resume from, or null to start from scratch.
+// Returns false on errors, which are printed.
+bool Exhaustive(Deck deck, Strategy strategy, const Options& options,
+                const Checkpoint* resumed, std::ostream& os) {
+  const unsigned num_threads = options.num_threads;
   // Doubles can represent integers up to 2^52, which is enough for anything
   // we can search exhaustively.
-  if (arena.stats().num_games > static_cast<double>(uint64_t{1} << 52)) {
+  const double num_games = GameArena::Stats(deck).num_games;
+  if (num_games > static_cast<double>(uint64_t{1} << 52)) {
     std::cerr << "too many games to explore, use the 'random' mode\n";
-    return;
+    return false;
   }
 
-  const auto start = std::chrono::system_clock::now();
-  const uint64_t num_games =
-      arena.stats().num_games + 1;  // +1 for numerical precision issues.
-  auto stats_snapshot = arena.stats().snapshot();
-  for (uint64_t i = 0; i < num_games; ++i) {
-    arena.Play(cards, strategy);
-    if ((arena.stats().num_played & 0xfffff) == 0 &&
-        (arena.stats().snapshot() != stats_snapshot)) {
-      arena.stats().Print(os);
-      os << "time: "
-         << std::chrono::duration_cast<std::chrono::seconds>(
-                std::chrono::system_clock::now() - start)
-         << "\n";
-      os.flush();
-      stats_snapshot = arena.stats().snapshot();
+  const std::vector<Card> sorted_cards = deck.Make();
+  const uint64_t num_ranks = bataille::NumPermutations(sorted_cards);
+  const bataille::IndexRange shard_range =
+      bataille::ShardRange(num_ranks, options.shard, options.num_shards);
+  // The games of the shard, counted like `num_games`.
+  const double shard_num_games = num_games * shard_range.size() / num_ranks;
+  Checkpoint checkpoint(deck);
+  std::vector<bataille::IndexRange> remaining;
+  if (resumed != nullptr) {
+    checkpoint.stats.Merge(resumed->stats);
+    checkpoint.elapsed = resumed->elapsed;
+    remaining = resumed->remaining;
+  } else {
+    remaining.push_back(shard_range);
+  }
+  checkpoint.mode = "exhaustive";
+  checkpoint.strategy = strategy;
+  checkpoint.num_threads = num_threads;
+  const auto start = std::chrono::system_clock::now() - checkpoint.elapsed;
+  bataille::WorkStealingRanges ranges(remaining, num_threads, kChunkSize);
+  const auto log = MakeGameLog({.deck = deck, .strategy = strategy}, options);
+  if (log == nullptr && !options.log_path.empty()) return false;
+
+  // One graph per strategy played, which the engines of the arenas use.
+  std::vector<std::unique_ptr<bataille::StateGraph>> graphs;
+  if (options.solve) {
+    const auto solve_start = std::chrono::steady_clock::now();
+    graphs.push_back(std::make_unique<bataille::StateGraph>(deck, strategy));
+    if (options.both) {
+      graphs.push_back(
+          std::make_unique<bataille::StateGraph>(deck, Strategy::kOptimized));
     }
-    if (!std::next_permutation(cards.begin(), cards.end())) {
-      break;  // Done.
+    uint64_t num_solved = 0;
+    for (const auto& graph : graphs) num_solved += graph->num_solved();
+    std::cout << "solved " << num_solved << " states in "
+              << std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - solve_start)
+                     .count()
+              << "s\n";
+  }
+
+  const auto cache = MakeCache(options);
+  GameArena::RecordQueue records, optimized_records;
+  GameArena::RecordQueue* const optimized_records_ptr =
+      options.both ? &optimized_records : nullptr;
+  const auto workers = MakeWorkers(deck, options, cache.get(), records,
+                                   optimized_records_ptr);
+  for (const auto& worker : workers) {
+    // Chunks are runs of consecutive permutations.
+    worker->arena.SetLexicographicDeals(true);
+    if (worker->optimized) worker->optimized->SetLexicographicDeals(true);
+    if (graphs.empty()) continue;
+    worker->arena.SetEngine(bataille::MakeStateGraphEngine(*graphs.front()));
+    if (worker->optimized) {
+      worker->optimized->SetEngine(
+          bataille::MakeStateGraphEngine(*graphs.back()));
+    }
+  }
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      Worker& worker = *workers[i];
+      std::vector<Card> cards = sorted_cards;
+      auto log_buffer = MakeGameLogBuffer(log.get());
+      DealBatch batch(deck, log_buffer ? &*log_buffer : nullptr, nullptr);
+      while (true) {
+        std::lock_guard<std::mutex> lock(worker.mu);
+        const auto chunk = ranges.Next(i);
+        if (!chunk) break;
+        // Lexicographic order keeps deals that only differ by their last
+        // cards together, for `PrefixSnapshot`. Only one deal of each
+        // mirrored pair is played: like `num_games`, stats count canonical
+        // deals, and the others are skipped without being enumerated.
+        bataille::Unrank(chunk->begin, cards);
+        for (uint64_t rank =
+                 chunk->begin + bataille::SkipToCanonicalDeal(cards);
+             rank < chunk->end;
+             rank += 1 + bataille::SkipToCanonicalDeal(cards)) {
+          if (batch.Add(cards, rank)) batch.Play(worker, strategy);
+          std::next_permutation(cards.begin(), cards.end());
+        }
+        batch.Play(worker, strategy);
+        UpdateNumPlayed(worker);
+      }
+    });
+  }
+
+  DoneNotification done;
+  std::thread reporter([&] {
+    ReportUntilDone(
+        checkpoint, workers, records, optimized_records_ptr, shard_num_games,
+        start, options,
+        [&](Checkpoint& c) { c.remaining = ranges.Remaining(); }, done, os);
+  });
+  for (std::thread& thread : threads) thread.join();
+  done.Notify();
+  reporter.join();
+  const bool log_ok = log == nullptr || log->Close();
+  if (!log_ok) std::cerr << "cannot write " << options.log_path << "\n";
+
+  const GameArena::Stats stats = PrintMergedStats(checkpoint, workers, os);
+  os << "total time: " << Elapsed(start) << "\n";
+  if (!options.shard_result_path.empty()) {
+    bataille::ShardResult result(deck);
+    result.strategy = strategy;
+    result.range = shard_range;
+    result.elapsed = Elapsed(start);
+    result.stats.Merge(stats);
+    if (!bataille::WriteShardResult(result, options.shard_result_path)) {
+      std::cerr << "cannot write " << options.shard_result_path << "\n";
+      return false;
     }
   }
-  arena.stats().Print(os);
-  os << "total time: "
-     << std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now() - start)
-     << "\n";
+  // The run is complete, there is nothing to resume.
+  if (!options.checkpoint_path.empty()) {
+    std::remove(options.checkpoint_path.c_str());
+  }
+  return log_ok;
+}
+
+// Returns the mt19937 generator of thread `thread` out of `num_threads`.
+// A single thread uses the plain generator seeded with `seed`, so that
+// single-threaded runs are reproducible with earlier versions. Otherwise each
+// thread gets its own stream, seeded from (seed, thread). These streams are
+// distinct but, unlike those of `ThreadXoshiro`, not guaranteed to be disjoint.
+std::mt19937 ThreadGenerator(unsigned seed, unsigned thread,
+                             unsigned num_threads) {
+  if (num_threads == 1) return std::mt19937(seed);
+  std::seed_seq seq = {seed, thread};
+  return std::mt19937(seq);
 }
 
-void Random(std::span<Card> cards, Strategy strategy, GameArena& arena,
-            const unsigned seed, std::ostream& os) {
-  std::mt19937 gen(seed);
+// Returns the xoshiro256** generator of thread `thread`: the generator seeded
+// with `seed`, jumped `thread` times, so that streams do not overlap.
+bataille::Xoshiro256StarStar ThreadXoshiro(unsigned seed, unsigned thread) {
+  bataille::Xoshiro256StarStar gen(seed);
+  for (unsigned i = 0; i < thread; ++i) gen.Jump();
+  return gen;
+}
+
+void ShuffleDeal(std::vector<Card>& cards, std::mt19937& gen) {
+  std::shuffle(cards.begin(), cards.end(), gen);
+}
+
+void ShuffleDeal(std::vector<Card>& cards, bataille::Xoshiro256StarStar& gen) {
+  bataille::Shuffle(cards, gen);
+}
 
+// Returns the state of the random generator `rng` and the last deal of
+// `worker`, as a single line.
+std::string RandomState(const Worker& worker, Rng rng) {
+  std::ostringstream state;
+  if (rng == Rng::kMt19937) {
+    state << worker.mt19937;
+  } else {
+    state << worker.xoshiro;
+  }
+  for (const Card card : worker.cards) state << " " << static_cast<int>(card);
+  return state.str();
+}
+
+// Restores a state returned by `RandomState`.
+bool SetRandomState(const std::string& state, Rng rng, Worker& worker) {
+  std::istringstream is(state);
+  if (rng == Rng::kMt19937) {
+    is >> worker.mt19937;
+  } else {
+    is >> worker.xoshiro;
+  }
+  for (Card& card : worker.cards) {
+    int value = 0;
+    is >> value;
+    card = value;
+  }
+  return !is.fail();
+}
+
+// `resumed` is the checkpoint to resume from, or null to start from scratch.
+// Returns false on errors, which are printed.
+bool Random(Deck deck, Strategy strategy, unsigned seed, Rng rng,
+            const Options& options, const Checkpoint* resumed,
+            std::ostream& os) {
+  const unsigned num_threads = options.num_threads;
+  Checkpoint checkpoint(deck);
+  if (resumed != nullptr) {
+    checkpoint.stats.Merge(resumed->stats);
+    checkpoint.estimates.Merge(resumed->estimates);
+    checkpoint.elapsed = resumed->elapsed;
+  }
+  checkpoint.mode = "random";
+  checkpoint.strategy = strategy;
+  checkpoint.seed = seed;
+  checkpoint.rng = rng;
+  checkpoint.num_threads = num_threads;
+  const auto start = std::chrono::system_clock::now() - checkpoint.elapsed;
+
+  const auto cache = MakeCache(options);
+  GameArena::RecordQueue records, optimized_records;
+  GameArena::RecordQueue* const optimized_records_ptr =
+      options.both ? &optimized_records : nullptr;
+  const auto workers = MakeWorkers(deck, options, cache.get(), records,
+                                   optimized_records_ptr);
+  const auto log = MakeGameLog(
+      {.deck = deck,
+       .strategy = strategy,
+       .exhaustive = false,
+       .seed = seed,
+       .rng = rng},
+      options);
+  if (log == nullptr && !options.log_path.empty()) return false;
+  for (unsigned i = 0; i < num_threads; ++i) {
+    Worker& worker = *workers[i];
+    if (resumed == nullptr) {
+      worker.mt19937 = ThreadGenerator(seed, i, num_threads);
+      worker.xoshiro = ThreadXoshiro(seed, i);
+    } else if (!SetRandomState(resumed->thread_states[i], rng, worker)) {
+      std::cerr << "invalid random state in checkpoint\n";
+      return false;
+    }
+  }
+  // Set when the estimates reach `options.precision`, checked by the workers
+  // between chunks.
+  std::atomic<bool> stop = false;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      Worker& worker = *workers[i];
+      auto log_buffer = MakeGameLogBuffer(log.get());
+      // The estimates are those of a single strategy.
+      DealBatch batch(deck, log_buffer ? &*log_buffer : nullptr,
+                      options.both ? nullptr : &worker.estimates);
+      // Deals are shuffled as they are added to the batch, before playing it.
+      const auto explore = [&](auto& gen) {
+        for (uint64_t deal = 0; !stop.load(std::memory_order_relaxed);) {
+          std::lock_guard<std::mutex> lock(worker.mu);
+          for (uint64_t j = 0; j < kChunkSize; ++j, ++deal) {
+            ShuffleDeal(worker.cards, gen);
+            if (batch.Add(worker.cards, bataille::RandomDealIndex(i, deal))) {
+              batch.Play(worker, strategy);
+            }
+          }
+          batch.Play(worker, strategy);
+          UpdateNumPlayed(worker);
+        }
+      };
+      if (rng == Rng::kMt19937) {
+        explore(worker.mt19937);
+      } else {
+        explore(worker.xoshiro);
+      }
+    });
+  }
+
+  DoneNotification done;
+  std::thread reporter([&] {
+    ReportUntilDone(
+        checkpoint, workers, records, optimized_records_ptr, 0, start, options,
+        [&](Checkpoint& c) {
+          for (const auto& worker : workers) {
+            c.thread_states.push_back(RandomState(*worker, rng));
+          }
+        },
+        done, os);
+  });
+  // Without a precision target, random exploration never ends.
+  do {
+    std::this_thread::sleep_for(options.report_interval);
+  } while (options.precision == 0 ||
+           !MergedEstimates(checkpoint.estimates, workers)
+                .Reached(options.precision));
+  stop = true;
+  for (std::thread& thread : threads) thread.join();
+  done.Notify();
+  reporter.join();
+  const bool log_ok = log == nullptr || log->Close();
+  if (!log_ok) std::cerr << "cannot write " << options.log_path << "\n";
+
+  std::cout << "precision " << options.precision << " reached\n";
+  MergedEstimates(checkpoint.estimates, workers).Print(std::cout);
+  os << "precision " << options.precision << " reached\n";
+  PrintMergedStats(checkpoint, workers, os);
+  os << "total time: " << Elapsed(start) << "\n";
+  // The run is complete, there is nothing to resume.
+  if (!options.checkpoint_path.empty()) {
+    std::remove(options.checkpoint_path.c_str());
+  }
+  return log_ok;
+}
+
+// Searches for record deals with one `DealSearch` per thread, the one of
+// thread `i` seeded with `ThreadXoshiro(seed, i)`. Searches are not
+// checkpointed: a resumed search would not find anything a new one would not.
+void Search(Deck deck, Strategy strategy, SearchObjective objective,
+            unsigned seed, const Options& options, std::ostream& os) {
+  // Steps of a search between two checks of the reporting thread.
+  constexpr uint64_t kStepsPerChunk =
+      kChunkSize / bataille::DealSearch::kNumCandidates;
+  Checkpoint checkpoint(deck);
   const auto start = std::chrono::system_clock::now();
 
-  auto stats_snapshot = arena.stats().snapshot();
-  while (true) {
-    std::shuffle(cards.begin(), cards.end(), gen);
-    arena.Play(cards, strategy);
-    if ((arena.stats().num_played & 0xfffff) == 0 &&
-        (arena.stats().snapshot() != stats_snapshot)) {
-      arena.stats().Print(os);
-      os << "time: "
-         << std::chrono::duration_cast<std::chrono::seconds>(
-                std::chrono::system_clock::now() - start)
-         << "\n";
-      os.flush();
-      stats_snapshot = arena.stats().snapshot();
+  const auto cache = MakeCache(options);
+  GameArena::RecordQueue records;
+  const auto workers =
+      MakeWorkers(deck, options, cache.get(), records, nullptr);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < options.num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      Worker& worker = *workers[i];
+      bataille::DealSearch search(deck, strategy, objective,
+                                  ThreadXoshiro(seed, i));
+      for (;;) {
+        std::lock_guard<std::mutex> lock(worker.mu);
+        search.Run(worker.arena, kStepsPerChunk);
+        UpdateNumPlayed(worker);
+      }
+    });
+  }
+
+  // Searches never end.
+  DoneNotification done;
+  ReportUntilDone(checkpoint, workers, records, nullptr, 0, start, options,
+                  [](Checkpoint&) {}, done, os);
+}
+
+// Plays the deals of `file`, and writes their results to `results_os`, one
+// line per deal, in the order of the file: the winner ("left", "right",
+// "draw" or "cycle") and the number of rounds, followed for cycles by `mu`
+// and `lambda`. Threads read chunks of deals in turn, and write their results
+// in the same order, so that there is at most one chunk per thread in memory.
+// Returns false if the file has an invalid deal, whose results are not
+// written, nor those of the deals after it.
+bool Eval(Deck deck, Strategy strategy, MappedDealFile& file,
+          const Options& options, std::ostream& results_os,
+          std::ostream& os) {
+  constexpr const char* kWinnerNames[] = {"left", "right", "draw", "cycle"};
+  const unsigned num_cards = deck.num_cards();
+  Checkpoint checkpoint(deck);
+  const auto start = std::chrono::system_clock::now();
+
+  const auto cache = MakeCache(options);
+  GameArena::RecordQueue records;
+  const auto workers =
+      MakeWorkers(deck, options, cache.get(), records, nullptr);
+  // Chunks are numbered in the order of the file, which is read with
+  // `read_mu` held.
+  std::mutex read_mu;
+  uint64_t num_chunks = 0;
+  // Results are written with `write_mu` held, in the order of the chunks.
+  std::mutex write_mu;
+  std::condition_variable written;
+  uint64_t num_written = 0;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < options.num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      Worker& worker = *workers[i];
+      std::vector<Card> deals(kChunkSize * num_cards);
+      std::vector<bataille::Game::Result> results(kChunkSize);
+      while (true) {
+        size_t num_deals = 0;
+        uint64_t chunk;
+        {
+          std::lock_guard<std::mutex> lock(read_mu);
+          while (num_deals < kChunkSize &&
+                 file.Next(std::span(deals).subspan(num_deals * num_cards,
+                                                    num_cards))) {
+            ++num_deals;
+          }
+          if (num_deals == 0) break;
+          chunk = num_chunks++;
+        }
+        {
+          std::lock_guard<std::mutex> lock(worker.mu);
+          worker.arena.PlayBatch(
+              std::span(deals).first(num_deals * num_cards),
+              std::span(results).first(num_deals), strategy);
+          UpdateNumPlayed(worker);
+        }
+        std::unique_lock<std::mutex> lock(write_mu);
+        written.wait(lock, [&] { return num_written == chunk; });
+        for (size_t j = 0; j < num_deals; ++j) {
+          const bataille::Game::Result& result = results[j];
+          results_os << kWinnerNames[static_cast<int>(result.winner)] << " "
+                     << result.num_steps;
+          if (result.winner == bataille::Game::Winner::kCycle) {
+            results_os << " " << result.mu << " " << result.lambda;
+          }
+          results_os << "\n";
+        }
+        ++num_written;
+        written.notify_all();
+      }
+    });
+  }
+
+  DoneNotification done;
+  std::thread reporter([&] {
+    ReportUntilDone(checkpoint, workers, records, nullptr, 0, start, options,
+                    [](Checkpoint&) {}, done, os);
+  });
+  for (std::thread& thread : threads) thread.join();
+  done.Notify();
+  reporter.join();
+
+  std::cout << "evaluated " << file.num_read() << " deals\n";
+  PrintMergedStats(checkpoint, workers, os);
+  os << "total time: " << Elapsed(start) << "\n";
+  results_os.flush();
+  if (!file.error().empty()) {
+    std::cerr << "invalid deal file: " << file.error() << "\n";
+    return false;
+  }
+  if (!results_os) {
+    std::cerr << "cannot write the results of the deals\n";
+    return false;
+  }
+  return true;
+}
+
+// Returns the name of the results files of an exploration, without extension.
+std::string ResultsName(Deck deck, Strategy strategy,
+                        const std::string& suffix) {
+  return "c" + std::to_string(deck.colors) + "v" +
+         std::to_string(deck.values) +
+         (strategy == Strategy::kNatural ? "" : "_opt") + suffix;
+}
+
+// Returns the name of the file at `path` without its directory and extension,
+// e.g. "c4v8_123" for "results/c4v8_123.txt".
+std::string FileStem(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  std::string name =
+      slash == std::string::npos ? path : path.substr(slash + 1);
+  const size_t dot = name.rfind('.');
+  if (dot != std::string::npos && dot > 0) name.resize(dot);
+  return name;
+}
+
+// Merges the shard results in `paths` into the results of the whole
+// exhaustive exploration.
+int Merge(const std::vector<std::string>& paths) {
+  std::vector<bataille::ShardResult> shards;
+  for (const std::string& path : paths) {
+    auto shard = bataille::ReadShardResult(path);
+    if (!shard) {
+      std::cerr << "cannot read shard result " << path << "\n";
+      return 1;
     }
+    shards.push_back(std::move(*shard));
+  }
+  std::string error;
+  const auto merged = bataille::MergeShards(shards, error);
+  if (!merged) {
+    std::cerr << "cannot merge shards: " << error << "\n";
+    return 1;
+  }
+
+  const Deck deck = merged->deck;
+  std::ofstream os(ResultsName(deck, merged->strategy, "") + ".txt");
+  if (!os) {
+    std::cerr << "cannot open output file\n";
+    return 1;
   }
+  os << "exhaustive exploration C=" << deck.colors << " V=" << deck.values
+     << "\n\n";
+  os << "merged " << shards.size() << " shards\n";
+  merged->stats.Print(os);
+  os << "total time: " << merged->elapsed << "\n";
+  return 0;
 }
 
 int main(int argc, char** argv) {
+  if (argc >= 3 && argv[1] == std::string_view("merge")) {
+    return Merge(std::vector<std::string>(argv + 2, argv + argc));
+  }
   if (argc < 5) {
-    std::cerr << argv[0] << " exhaustive|random natural|optimized C V [seed]\n";
+    std::cerr << argv[0]
+              << " exhaustive|random|search natural|optimized|both C V [seed]"
+                 " [--threads N] [--cache_mb N] [--checkpoint_interval S]"
+                 " [--report_interval S] [--progress]"
+                 " [--resume] [--shard K/N] [--log]"
+                 " [--rng mt19937|xoshiro256**]"
+                 " [--objective longest|shortest_cycle] [--solve]"
+                 " [--precision E]\n"
+              << argv[0] << " eval natural|optimized C V DEAL_FILE"
+                 " [--threads N] [--cache_mb N] [--report_interval S]"
+                 " [--progress]\n"
+              << argv[0] << " merge SHARD_RESULT...\n";
     return 1;
   }
 
   bool exhaustive = false;
+  bool search = false;
+  bool eval = false;
   if (argv[1] == std::string_view("exhaustive")) {
     exhaustive = true;
+  } else if (argv[1] == std::string_view("search")) {
+    search = true;
+  } else if (argv[1] == std::string_view("eval")) {
+    eval = true;
   } else if (argv[1] != std::string_view("random")) {
     std::cerr << "invalid exploration mode '" << argv[1] << "'\n";
+    return 1;
   }
 
   Strategy strategy = Strategy::kNatural;
+  Options options;
   if (argv[2] == std::string_view("optimized")) {
     strategy = Strategy::kOptimized;
-  } else if (argv[2] != std::string_view("random")) {
-    std::cerr << "invalid exploration mode '" << argv[1] << "'\n";
+  } else if (argv[2] == std::string_view("both")) {
+    options.both = true;
+  } else if (argv[2] != std::string_view("natural")) {
+    std::cerr << "invalid strategy '" << argv[2] << "'\n";
+    return 1;
   }
   const Deck deck = {.colors = static_cast<unsigned>(std::atoi(argv[3])),
                      .values = static_cast<unsigned>(std::atoi(argv[4]))};
+
+  std::optional<unsigned> seed_flag;
+  std::string deal_path;
+  bool resume = false;
+  bool log = false;
+  bool progress = false;
+  Rng rng = Rng::kXoshiro256StarStar;
+  SearchObjective objective = SearchObjective::kLongest;
+  for (int i = 5; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      options.num_threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--cache_mb" && i + 1 < argc) {
+      options.cache_mb = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--checkpoint_interval" && i + 1 < argc) {
+      options.checkpoint_interval =
+          std::chrono::seconds(std::max(0, std::atoi(argv[++i])));
+    } else if (arg == "--report_interval" && i + 1 < argc) {
+      options.report_interval =
+          std::chrono::seconds(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--progress") {
+      progress = true;
+    } else if (arg == "--resume") {
+      resume = true;
+    } else if (arg == "--shard" && i + 1 < argc) {
+      const std::string_view shard = argv[++i];
+      const size_t slash = shard.find('/');
+      options.shard = std::atoi(argv[i]);
+      options.num_shards = slash == std::string_view::npos
+                               ? 0
+                               : std::atoi(argv[i] + slash + 1);
+      if (!exhaustive || options.shard >= options.num_shards) {
+        std::cerr << "invalid shard '" << shard
+                  << "', expected K/N with 0 <= K < N in exhaustive mode\n";
+        return 1;
+      }
+    } else if (arg == "--rng" && i + 1 < argc) {
+      const std::optional<Rng> parsed_rng = bataille::ParseRng(argv[++i]);
+      if (!parsed_rng || exhaustive || search || eval) {
+        std::cerr << "invalid random generator '" << argv[i]
+                  << "', expected mt19937 or xoshiro256** in random mode\n";
+        return 1;
+      }
+      rng = *parsed_rng;
+    } else if (arg == "--objective" && i + 1 < argc) {
+      const std::optional<SearchObjective> parsed_objective =
+          bataille::ParseSearchObjective(argv[++i]);
+      if (!parsed_objective || !search) {
+        std::cerr << "invalid objective '" << argv[i]
+                  << "', expected longest or shortest_cycle in search mode\n";
+        return 1;
+      }
+      objective = *parsed_objective;
+    } else if (arg == "--log") {
+      log = true;
+    } else if (arg == "--solve") {
+      const uint64_t num_states = bataille::StateGraph::NumStates(deck);
+      if (!exhaustive || num_states == 0 ||
+          num_states > bataille::StateGraph::kMaxStates) {
+        std::cerr << "--solve needs the exhaustive mode and a deck with at"
+                     " most "
+                  << bataille::StateGraph::kMaxStates << " states\n";
+        return 1;
+      }
+      options.solve = true;
+    } else if (arg == "--precision" && i + 1 < argc) {
+      options.precision = std::atof(argv[++i]);
+      if (exhaustive || search || eval || options.both ||
+          !(options.precision > 0) ||
+          options.precision >= 1) {
+        std::cerr << "invalid precision '" << argv[i]
+                  << "', expected 0 < E < 1 in random mode, with the natural"
+                     " or optimized strategy\n";
+        return 1;
+      }
+    } else if (eval && !arg.starts_with("--") && deal_path.empty()) {
+      deal_path = arg;
+    } else if (!eval && !arg.starts_with("--") && !seed_flag) {
+      seed_flag = std::atoi(argv[i]);
+    } else {
+      std::cerr << "invalid argument '" << arg << "'\n";
+      return 1;
+    }
+  }
+  // Games played again after resuming would be logged twice.
+  if (resume && log) {
+    std::cerr << "--log cannot be used with --resume\n";
+    return 1;
+  }
+  // Searches play the same deals many times, and are not checkpointed.
+  if (search && (resume || log)) {
+    std::cerr << "--resume and --log cannot be used in search mode\n";
+    return 1;
+  }
+  // The stats of both strategies are reported together, but checkpoints,
+  // shard results, game logs and progress files have a single strategy.
+  if (options.both && (search || resume || options.num_shards > 1 || log ||
+                       progress)) {
+    std::cerr << "the 'both' strategy cannot be used in search mode, nor with"
+                 " --resume, --shard, --log or --progress\n";
+    return 1;
+  }
+  // Deal files are read once, with a single strategy, and their results are
+  // written in order.
+  if (eval && (deal_path.empty() || options.both || resume || log)) {
+    std::cerr << "eval needs a deal file and the natural or optimized"
+                 " strategy, and cannot be used with --resume or --log\n";
+    return 1;
+  }
+  if (resume && !exhaustive && !seed_flag) {
+    std::cerr << "--resume needs the seed of the random run\n";
+    return 1;
+  }
   const unsigned seed =
-      exhaustive ? 0
-                 : (argc >= 6 ? std::atoi(argv[5]) : std::random_device()());
+      exhaustive || eval ? 0 : seed_flag.value_or(std::random_device()());
+
+  std::string results_suffix = "_" + std::to_string(seed);
+  if (eval) {
+    // Evaluations of different deal files go to different files.
+    results_suffix = "_eval_" + FileStem(deal_path);
+  } else if (exhaustive) {
+    results_suffix = options.num_shards > 1
+                         ? "_shard" + std::to_string(options.shard) + "of" +
+                               std::to_string(options.num_shards)
+                         : "";
+  } else if (search) {
+    results_suffix = "_search_" +
+                     std::string(bataille::SearchObjectiveName(objective)) +
+                     results_suffix;
+  }
+  if (options.both) results_suffix = "_both" + results_suffix;
+  const std::string results_name = ResultsName(deck, strategy, results_suffix);
+  const std::string output_path = results_name + ".txt";
+  if (!search && !eval && !options.both) {
+    options.checkpoint_path = output_path + ".checkpoint";
+  }
+  if (log) options.log_path = results_name + ".log";
+  if (options.num_shards > 1) {
+    options.shard_result_path = results_name + ".shard";
+  }
 
-  std::ofstream os("c" + std::to_string(deck.colors) + "v" +
-                   std::to_string(deck.values) +
-                   (strategy == Strategy::kNatural ? "" : "_opt") +
-                   (exhaustive ? "" : "_" + std::to_string(seed)) + ".txt");
+  const std::optional<Checkpoint> resumed =
+      resume ? bataille::LoadCheckpoint(options.checkpoint_path) : std::nullopt;
+  if (resume) {
+    if (!resumed) {
+      std::cerr << "cannot read checkpoint " << options.checkpoint_path
+                << "\n";
+      return 1;
+    }
+    if (resumed->mode != argv[1] || resumed->strategy != strategy ||
+        resumed->deck.colors != deck.colors ||
+        resumed->deck.values != deck.values ||
+        resumed->thread_states.size() !=
+            (exhaustive ? 0 : resumed->num_threads)) {
+      std::cerr << "checkpoint " << options.checkpoint_path
+                << " is for another exploration\n";
+      return 1;
+    }
+    // Each thread of a random run has its own stream.
+    if (!exhaustive) {
+      options.num_threads = resumed->num_threads;
+      rng = resumed->rng;
+    }
+  }
+
+  std::string deal_file_error;
+  std::optional<MappedDealFile> deal_file =
+      eval ? MappedDealFile::Open(deal_path, deck, deal_file_error)
+           : std::nullopt;
+  std::ofstream eval_results_os;
+  if (eval) {
+    if (!deal_file) {
+      std::cerr << deal_file_error << "\n";
+      return 1;
+    }
+    eval_results_os.open(results_name + ".results");
+    if (!eval_results_os) {
+      std::cerr << "cannot open results file\n";
+      return 1;
+    }
+  }
+
+  std::ofstream os(output_path, resumed ? std::ios::app : std::ios::trunc);
   if (!os) {
     std::cerr << "cannot open output file\n";
     return 1;
   }
+  std::ofstream progress_os;
+  if (progress) {
+    progress_os.open(results_name + ".jsonl",
+                     resumed ? std::ios::app : std::ios::trunc);
+    if (!progress_os) {
+      std::cerr << "cannot open progress file\n";
+      return 1;
+    }
+    options.progress = &progress_os;
+  }
 
-  os << (exhaustive ? "exhaustive" : "random")
-     << " exploration C=" << deck.colors << " V=" << deck.values << "\n\n";
+  if (resumed) {
+    os << "resumed after " << resumed->elapsed << "\n";
+    os.flush();
+  } else if (eval) {
+    os << "evaluation of " << deal_path << " C=" << deck.colors
+       << " V=" << deck.values << "\n\n";
+  } else {
+    os << (exhaustive ? "exhaustive" : search ? "search" : "random")
+       << " exploration C=" << deck.colors << " V=" << deck.values << "\n\n";
+  }
 
-  std::vector<Card> cards = deck.Make();
-  GameArena arena(deck);
+  const Checkpoint* const resumed_ptr = resumed ? &*resumed : nullptr;
   if (exhaustive) {
-    Exhaustive(cards, strategy, arena, os);
-  } else {
+    if (!resumed && options.num_shards > 1) {
+      os << "shard=" << options.shard << "/" << options.num_shards << "\n";
+    }
+    if (!Exhaustive(deck, strategy, options, resumed_ptr, os)) return 1;
+  } else if (eval) {
+    if (!Eval(deck, strategy, *deal_file, options, eval_results_os, os)) {
+      return 1;
+    }
+  } else if (search) {
     os << "seed=" << seed << "\n";
-    Random(cards, strategy, arena, seed, os);
+    os << "objective=" << bataille::SearchObjectiveName(objective) << "\n";
+    if (options.num_threads > 1) {
+      os << "threads=" << options.num_threads << "\n";
+    }
+    Search(deck, strategy, objective, seed, options, os);
+  } else {
+    if (!resumed) {
+      os << "seed=" << seed << "\n";
+      os << "rng=" << bataille::RngName(rng) << "\n";
+      if (options.num_threads > 1) {
+        os << "threads=" << options.num_threads << "\n";
+      }
+    }
+    if (!Random(deck, strategy, seed, rng, options, resumed_ptr, os)) {
+      return 1;
+    }
   }
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,212 @@
+#ifndef FIXED_GAME_H
+#define FIXED_GAME_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "bataille.h"
+#include "instrument.h"
+
+namespace bataille {
+
+// A hand of at most `kMaxCards` cards, in a ring whose size is known at compile
+// time.
+template <unsigned kMaxCards>
+class FixedHand {
+ public:
+  static constexpr uint32_t kCapacity = std::bit_ceil(kMaxCards);
+
+  void Assign(const Card* cards, unsigned n) {
+    assert(n <= kMaxCards);
+    for (unsigned i = 0; i < n; ++i) cards_[i] = cards[i];
+    head_ = 0;
+    size_ = n;
+  }
+
+  friend bool operator==(const FixedHand& l, const FixedHand& r) {
+    if (l.size_ != r.size_) return false;
+    for (uint32_t i = 0; i < l.size_; ++i) {
+      if (l.cards_[(l.head_ + i) & kMask] != r.cards_[(r.head_ + i) & kMask]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool empty() const { return size_ == 0; }
+  uint32_t size() const { return size_; }
+
+  // See `Hand::AddTo`.
+  void AddTo(StateKey& key) const {
+    key.Add(size_);
+    uint64_t word = 0;
+    for (uint32_t i = 0; i < size_; ++i) {
+      word |= uint64_t{cards_[(head_ + i) & kMask]} << (8 * (i % 8));
+      if (i % 8 == 7) {
+        key.Add(word);
+        word = 0;
+      }
+    }
+    key.Add(word);
+  }
+
+  std::string DebugString() const {
+    std::string str = "[";
+    for (uint32_t i = 0; i < size_; ++i) {
+      str.append(std::to_string(cards_[(head_ + i) & kMask]));
+      str.push_back(',');
+    }
+    str.push_back(']');
+    return str;
+  }
+
+  Card Top() const {
+    assert(!empty());
+    return cards_[head_ & kMask];
+  }
+
+  // Remove the top card of the hand.
+  Card Pop() {
+    assert(!empty());
+    const Card card = cards_[head_ & kMask];
+    ++head_;
+    --size_;
+    return card;
+  }
+
+  // Add a card at the bottom.
+  void Push(Card card) {
+    assert(size_ < kMaxCards);
+    cards_[(head_ + size_) & kMask] = card;
+    ++size_;
+  }
+
+  // Writes `hi` then `lo` past the bottom of the hand, and adds them to the
+  // hand if `keep`. There must be room for two more cards either way.
+  void PushPairIf(Card hi, Card lo, bool keep) {
+    assert(size_ + 2 <= kCapacity);
+    cards_[(head_ + size_) & kMask] = hi;
+    cards_[(head_ + size_ + 1) & kMask] = lo;
+    size_ += 2 * keep;
+  }
+
+ private:
+  static constexpr uint32_t kMask = kCapacity - 1;
+
+  std::array<Card, kCapacity> cards_;
+  // Not wrapped, use `head_ & kMask`.
+  uint32_t head_ = 0;
+  uint32_t size_ = 0;
+};
+
+// Same as `Game`, for a deck and a strategy known at compile time: hands are
+// fixed-size arrays, and the order in which cards are given back is resolved
+// at compile time.
+template <unsigned kColors, unsigned kValues, Strategy kStrategy>
+class FixedGame {
+ public:
+  static constexpr unsigned kNumCards = kColors * kValues;
+  static_assert(kNumCards >= 2);
+
+  explicit FixedGame(Deck deck) {
+    assert(deck.colors == kColors);
+    assert(deck.values == kValues);
+    (void)deck;
+  }
+
+  void Deal(std::span<const Card> cards) {
+    assert(cards.size() == kNumCards);
+    l_.Assign(cards.data(), kNumCards / 2);
+    r_.Assign(cards.data() + kNumCards / 2, kNumCards - kNumCards / 2);
+  }
+
+  const FixedHand<kNumCards>& left() const { return l_; }
+  const FixedHand<kNumCards>& right() const { return r_; }
+
+  friend bool operator==(const FixedGame& lhs, const FixedGame& rhs) {
+    return lhs.l_ == rhs.l_ && lhs.r_ == rhs.r_;
+  }
+
+  // See `Game::Key`.
+  StateKey Key() const {
+    StateKey key;
+    l_.AddTo(key);
+    r_.AddTo(key);
+    return key;
+  }
+
+  // See `Game::Step`. `strategy` must be `kStrategy`.
+  bool Step([[maybe_unused]] Strategy strategy) {
+    assert(strategy == kStrategy);
+    unsigned num_ties = 0;
+    Card cl = l_.Pop();
+    Card cr = r_.Pop();
+    while (cl == cr) {
+      // Tie.
+      ties_[num_ties] = cl;
+      ++num_ties;
+      if (l_.empty() || r_.empty()) return true;
+      cl = l_.Pop();
+      cr = r_.Pop();
+    }
+    BATAILLE_COUNT(Ties(num_ties, kStrategy));
+    const std::span<Card> ties(ties_.data(), num_ties);
+    if (cr < cl) {
+      PushRoundCards(cl, cr, ties, kStrategy, [this](Card c) { l_.Push(c); });
+    } else {
+      PushRoundCards(cr, cl, ties, kStrategy, [this](Card c) { r_.Push(c); });
+    }
+    return l_.empty() || r_.empty();
+  }
+
+  // See `Game::Step`.
+  bool Step(Strategy strategy, unsigned max_rounds,
+            const FixedGame* stop_at, unsigned& num_rounds) {
+    assert(max_rounds > 0);
+    unsigned i = 0;
+    while (true) {
+      ++i;
+      if (i % InstrumentCounters::kHandSizePeriod == 0) [[unlikely]] {
+        BATAILLE_COUNT(left_hand_sizes.Add(l_.size()));
+      }
+      if (l_.Top() == r_.Top()) {
+        if (Step(strategy)) break;
+      } else {
+        const Card cl = l_.Pop();
+        const Card cr = r_.Pop();
+        const bool left_wins = cr < cl;
+        l_.PushPairIf(std::max(cl, cr), std::min(cl, cr), left_wins);
+        r_.PushPairIf(std::max(cl, cr), std::min(cl, cr), !left_wins);
+        if (l_.empty() || r_.empty()) break;
+      }
+      if (i == max_rounds || (stop_at != nullptr && *this == *stop_at)) {
+        num_rounds = i;
+        return false;
+      }
+    }
+    num_rounds = i;
+    return true;
+  }
+
+  Game::Winner GetWinner() const {
+    return l_.empty() && r_.empty()
+               ? Game::Winner::kDraw
+               : (l_.empty() ? Game::Winner::kRight : Game::Winner::kLeft);
+  }
+
+  Deck deck() const { return {.colors = kColors, .values = kValues}; }
+
+ private:
+  FixedHand<kNumCards> l_;
+  FixedHand<kNumCards> r_;
+  std::array<Card, kNumCards / 2> ties_;
+};
+
+}  // namespace bataille
+
+#endif  // FIXED_GAME_H
@@ -0,0 +1,138 @@
+#include "fixed_game.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "engine.h"
+
+namespace bataille {
+namespace {
+
+TEST(FixedHandTest, Basic) {
+  FixedHand<6> hand;
+  EXPECT_TRUE(hand.empty());
+  const Card cards[] = {3, 15, 1};
+  hand.Assign(cards, 3);
+  EXPECT_EQ(hand.DebugString(), "[3,15,1,]");
+  EXPECT_EQ(hand.Pop(), 3);
+  hand.Push(7);
+  EXPECT_EQ(hand.DebugString(), "[15,1,7,]");
+  // Wrap around.
+  for (Card c = 8; c < 14; ++c) {
+    hand.Pop();
+    hand.Push(c);
+  }
+  EXPECT_EQ(hand.DebugString(), "[11,12,13,]");
+}
+
+TEST(FixedHandTest, Equality) {
+  FixedHand<4> hand;
+  hand.Push(1);
+  hand.Push(2);
+  FixedHand<4> copy = hand;
+  EXPECT_TRUE(hand == copy);
+  copy.Pop();
+  EXPECT_FALSE(hand == copy);
+  copy.Push(1);
+  EXPECT_FALSE(hand == copy);
+  // Same cards at different positions in the ring.
+  copy.Pop();
+  copy.Push(1);
+  copy.Push(2);
+  copy.Pop();
+  EXPECT_TRUE(hand == copy);
+}
+
+// Plays random deals step by step with `Game` and `FixedGame`.
+template <unsigned kColors, unsigned kValues, Strategy kStrategy>
+void ExpectSameAsGame() {
+  const Deck deck = {.colors = kColors, .values = kValues};
+  std::mt19937 gen(42);
+  std::vector<Card> cards = deck.Make();
+  Game game(deck);
+  FixedGame<kColors, kValues, kStrategy> fixed(deck);
+  for (int i = 0; i < 100; ++i) {
+    std::shuffle(cards.begin(), cards.end(), gen);
+    game.Deal(cards);
+    fixed.Deal(cards);
+    for (int step = 0; step < 1000; ++step) {
+      const bool done = game.Step(kStrategy);
+      ASSERT_EQ(fixed.Step(kStrategy), done);
+      ASSERT_EQ(fixed.left().DebugString(), game.left().DebugString());
+      ASSERT_EQ(fixed.right().DebugString(), game.right().DebugString());
+      if (done) {
+        EXPECT_EQ(fixed.GetWinner(), game.GetWinner());
+        break;
+      }
+    }
+  }
+}
+
+TEST(FixedGameTest, SameAsGame) {
+  ExpectSameAsGame<4, 5, Strategy::kNatural>();
+  ExpectSameAsGame<4, 5, Strategy::kOptimized>();
+  ExpectSameAsGame<4, 13, Strategy::kNatural>();
+  ExpectSameAsGame<4, 13, Strategy::kOptimized>();
+  ExpectSameAsGame<3, 7, Strategy::kNatural>();
+}
+
+TEST(FixedGameTest, StepManyRounds) {
+  const Deck deck = {.colors = 4, .values = 7};
+  std::mt19937 gen(42);
+  std::vector<Card> cards = deck.Make();
+  Game game(deck);
+  FixedGame<4, 7, Strategy::kNatural> fixed(deck);
+  for (int i = 0; i < 100; ++i) {
+    std::shuffle(cards.begin(), cards.end(), gen);
+    game.Deal(cards);
+    fixed.Deal(cards);
+    for (unsigned max_rounds = 1; max_rounds < 5000; ++max_rounds) {
+      unsigned num_rounds = 0;
+      const bool done = fixed.Step(Strategy::kNatural, max_rounds % 20 + 1,
+                                   nullptr, num_rounds);
+      bool expected_done = false;
+      for (unsigned round = 0; round < num_rounds; ++round) {
+        ASSERT_FALSE(expected_done);
+        expected_done = game.Step(Strategy::kNatural);
+      }
+      ASSERT_EQ(done, expected_done);
+      ASSERT_EQ(fixed.left().DebugString(), game.left().DebugString());
+      ASSERT_EQ(fixed.right().DebugString(), game.right().DebugString());
+      if (done) break;
+    }
+  }
+}
+
+TEST(FixedEngineTest, Decks) {
+  EXPECT_NE(MakeFixedEngine({.colors = 1, .values = 2}), nullptr);
+  EXPECT_NE(MakeFixedEngine(Deck::Standard54()), nullptr);
+  EXPECT_EQ(MakeFixedEngine({.colors = 1, .values = 1}), nullptr);
+  EXPECT_EQ(MakeFixedEngine({.colors = 5, .values = 4}), nullptr);
+  EXPECT_EQ(MakeFixedEngine(Deck::Seq(14)), nullptr);
+}
+
+TEST(FixedEngineTest, SameAsGenericEngine) {
+  for (const Deck deck :
+       {Deck{.colors = 2, .values = 4}, Deck{.colors = 3, .values = 3}}) {
+    for (const Strategy strategy :
+         {Strategy::kNatural, Strategy::kOptimized}) {
+      const auto generic = MakeGenericEngine(deck);
+      const auto fixed = MakeFixedEngine(deck);
+      std::vector<Card> cards = deck.Make();
+      do {
+        const Game::Result expected = generic->Play(cards, strategy);
+        const Game::Result result = fixed->Play(cards, strategy);
+        ASSERT_EQ(result.winner, expected.winner);
+        ASSERT_EQ(result.num_steps, expected.num_steps);
+        ASSERT_EQ(result.mu, expected.mu);
+        ASSERT_EQ(result.lambda, expected.lambda);
+      } while (std::next_permutation(cards.begin(), cards.end()));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace bataille
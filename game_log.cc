@@ -0,0 +1,183 @@
+#include "game_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+constexpr std::string_view kMagic = "BTLLOG01";
+
+void PutU32(uint32_t value, uint8_t* bytes) {
+  for (int i = 0; i < 4; ++i) bytes[i] = value >> (8 * i);
+}
+
+uint32_t GetU32(const uint8_t* bytes) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) value |= uint32_t{bytes[i]} << (8 * i);
+  return value;
+}
+
+std::vector<uint8_t> EncodeHeader(const GameLogHeader& header) {
+  std::vector<uint8_t> bytes(kGameLogHeaderSize);
+  std::memcpy(bytes.data(), kMagic.data(), kMagic.size());
+  uint8_t* const fields = bytes.data() + kMagic.size();
+  PutU32(header.deck.colors, fields);
+  PutU32(header.deck.values, fields + 4);
+  PutU32(static_cast<uint32_t>(header.strategy), fields + 8);
+  PutU32(header.exhaustive ? 0 : 1, fields + 12);
+  PutU32(header.seed, fields + 16);
+  PutU32(static_cast<uint32_t>(header.rng), fields + 20);
+  return bytes;
+}
+
+std::optional<GameLogHeader> DecodeHeader(std::span<const uint8_t> bytes) {
+  if (bytes.size() < kGameLogHeaderSize ||
+      std::memcmp(bytes.data(), kMagic.data(), kMagic.size()) != 0) {
+    return std::nullopt;
+  }
+  const uint8_t* const fields = bytes.data() + kMagic.size();
+  const uint32_t strategy = GetU32(fields + 8);
+  const uint32_t mode = GetU32(fields + 12);
+  const uint32_t rng = GetU32(fields + 20);
+  if (strategy > 1 || mode > 1 || rng > 1) return std::nullopt;
+  return GameLogHeader{.deck = {.colors = GetU32(fields),
+                                .values = GetU32(fields + 4)},
+                       .strategy = static_cast<Strategy>(strategy),
+                       .exhaustive = mode == 0,
+                       .seed = GetU32(fields + 16),
+                       .rng = static_cast<Rng>(rng)};
+}
+
+}  // namespace
+
+GameLogWriter::GameLogWriter(const std::string& path,
+                             const GameLogHeader& header)
+    : file_(std::fopen(path.c_str(), "wb")) {
+  if (file_ == nullptr) {
+    error_ = true;
+  } else {
+    const std::vector<uint8_t> bytes = EncodeHeader(header);
+    error_ = std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size();
+  }
+  thread_ = std::thread([this] { WriteLoop(); });
+}
+
+GameLogWriter::~GameLogWriter() { Close(); }
+
+bool GameLogWriter::ok() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return !error_;
+}
+
+bool GameLogWriter::Close() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      closing_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    if (file_ != nullptr && std::fclose(file_) != 0) error_ = true;
+    file_ = nullptr;
+  }
+  return !error_;
+}
+
+std::vector<uint8_t> GameLogWriter::Submit(std::vector<uint8_t> block,
+                                           size_t size) {
+  std::unique_lock<std::mutex> lock(mu_);
+  cv_.wait(lock, [this] { return pending_.size() < kMaxPendingBlocks; });
+  pending_.emplace_back(std::move(block), size);
+  std::vector<uint8_t> empty;
+  if (!free_.empty()) {
+    empty = std::move(free_.back());
+    free_.pop_back();
+  }
+  lock.unlock();
+  cv_.notify_all();
+  return empty;
+}
+
+void GameLogWriter::WriteLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    cv_.wait(lock, [this] { return closing_ || !pending_.empty(); });
+    if (pending_.empty()) return;
+    auto [block, size] = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    cv_.notify_all();
+    const bool written = file_ != nullptr &&
+                         std::fwrite(block.data(), 1, size, file_) == size;
+    lock.lock();
+    if (!written) error_ = true;
+    free_.push_back(std::move(block));
+  }
+}
+
+GameLogWriter::Buffer::Buffer(GameLogWriter& writer)
+    : writer_(writer), block_(kRecordsPerBlock * kGameLogRecordSize) {}
+
+GameLogWriter::Buffer::~Buffer() { Flush(); }
+
+void GameLogWriter::Buffer::Flush() {
+  if (size_ == 0) return;
+  block_ = writer_.Submit(std::move(block_), size_);
+  block_.resize(kRecordsPerBlock * kGameLogRecordSize);
+  size_ = 0;
+}
+
+std::optional<MappedGameLog> MappedGameLog::Open(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return std::nullopt;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < kGameLogHeaderSize) {
+    close(fd);
+    return std::nullopt;
+  }
+  const size_t mapped_size = st.st_size;
+  void* const data = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return std::nullopt;
+  const auto* const bytes = static_cast<const uint8_t*>(data);
+  const auto header = DecodeHeader(std::span(bytes, mapped_size));
+  if (!header) {
+    munmap(data, mapped_size);
+    return std::nullopt;
+  }
+  madvise(data, mapped_size, MADV_SEQUENTIAL);
+  return MappedGameLog(bytes, mapped_size, *header);
+}
+
+MappedGameLog::MappedGameLog(const uint8_t* data, size_t mapped_size,
+                             const GameLogHeader& header)
+    : data_(data),
+      mapped_size_(mapped_size),
+      header_(header),
+      size_((mapped_size - kGameLogHeaderSize) / kGameLogRecordSize) {}
+
+MappedGameLog::MappedGameLog(MappedGameLog&& other)
+    : data_(std::exchange(other.data_, nullptr)),
+      mapped_size_(other.mapped_size_),
+      header_(other.header_),
+      size_(other.size_) {}
+
+MappedGameLog::~MappedGameLog() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), mapped_size_);
+  }
+}
+
+}  // namespace bataille
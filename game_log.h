@@ -0,0 +1,168 @@
+#ifndef GAME_LOG_H
+#define GAME_LOG_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bataille.h"
+#include "rng.h"
+
+namespace bataille {
+
+// A game log records the result of every game of an exploration, for offline
+// analysis. It is a binary file: a header of `kGameLogHeaderSize` bytes,
+// followed by records of `kGameLogRecordSize` bytes. All integers are little
+// endian.
+//
+// Header: the magic "BTLLOG01", then the colors, values, strategy, mode
+// (0 for exhaustive, 1 for random), seed and random generator (see `Rng`) as
+// 32-bit integers, then zeros.
+//
+// Record: the index of the deal (64 bits), then the number of steps (30 bits)
+// and the winner (2 bits) packed in 32 bits. In exhaustive mode, the index is
+// the rank of the deal (see `Rank`). In random mode, it is the thread in the
+// top 16 bits and the number of deals shuffled before by that thread in the
+// low 48 bits.
+
+constexpr size_t kGameLogHeaderSize = 32;
+constexpr size_t kGameLogRecordSize = 12;
+
+struct GameLogHeader {
+  Deck deck;
+  Strategy strategy = Strategy::kNatural;
+  bool exhaustive = true;
+  unsigned seed = 0;
+  Rng rng = Rng::kMt19937;
+};
+
+struct GameLogRecord {
+  uint64_t index;
+  Game::Winner winner;
+  unsigned num_steps;
+};
+
+// Returns the index of the `deal`-th deal shuffled by `thread` in random mode.
+inline uint64_t RandomDealIndex(unsigned thread, uint64_t deal) {
+  return uint64_t{thread} << 48 | deal;
+}
+
+// Writes a game log. Each exploration thread fills its own `Buffer`, which
+// hands full blocks of records to a background thread that writes them, so
+// that exploration threads never wait for the disk unless it falls behind.
+class GameLogWriter {
+ public:
+  static constexpr size_t kRecordsPerBlock = 1 << 16;
+  // Threads adding records wait when that many blocks are waiting to be
+  // written.
+  static constexpr size_t kMaxPendingBlocks = 16;
+
+  // Creates `path` and writes the header. Check `ok()` for errors.
+  GameLogWriter(const std::string& path, const GameLogHeader& header);
+  // Writes the pending blocks, see `Close`.
+  ~GameLogWriter();
+  GameLogWriter(const GameLogWriter&) = delete;
+  GameLogWriter& operator=(const GameLogWriter&) = delete;
+
+  // Returns false if the file cannot be written.
+  bool ok() const;
+
+  // Writes the pending blocks and closes the file. All buffers must have been
+  // destroyed. Returns false if anything could not be written.
+  bool Close();
+
+  // Records of one thread, waiting to be written.
+  class Buffer {
+   public:
+    explicit Buffer(GameLogWriter& writer);
+    // Hands the remaining records to the writer.
+    ~Buffer();
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    void Add(uint64_t index, const Game::Result& result) {
+      uint8_t* const record = block_.data() + size_;
+      const uint32_t packed =
+          std::min(result.num_steps, (1u << 30) - 1) << 2 |
+          static_cast<uint32_t>(result.winner);
+      for (int i = 0; i < 8; ++i) record[i] = index >> (8 * i);
+      for (int i = 0; i < 4; ++i) record[8 + i] = packed >> (8 * i);
+      size_ += kGameLogRecordSize;
+      if (size_ == block_.size()) Flush();
+    }
+
+    // Hands the records added so far to the writer.
+    void Flush();
+
+   private:
+    GameLogWriter& writer_;
+    std::vector<uint8_t> block_;
+    size_t size_ = 0;
+  };
+
+ private:
+  // Queues the first `size` bytes of `block` for writing, and returns an empty
+  // block.
+  std::vector<uint8_t> Submit(std::vector<uint8_t> block, size_t size);
+  void WriteLoop();
+
+  std::FILE* file_;
+  bool error_ = false;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  // Blocks waiting to be written, with their sizes.
+  std::deque<std::pair<std::vector<uint8_t>, size_t>> pending_;
+  // Written blocks, to be reused.
+  std::vector<std::vector<uint8_t>> free_;
+  bool closing_ = false;
+  std::thread thread_;
+};
+
+// A game log mapped in memory.
+class MappedGameLog {
+ public:
+  // Returns std::nullopt if `path` cannot be mapped or is not a game log. A
+  // truncated last record (from an interrupted run) is ignored.
+  static std::optional<MappedGameLog> Open(const std::string& path);
+
+  MappedGameLog(MappedGameLog&& other);
+  MappedGameLog& operator=(MappedGameLog&&) = delete;
+  ~MappedGameLog();
+
+  const GameLogHeader& header() const { return header_; }
+  size_t size() const { return size_; }
+
+  GameLogRecord operator[](size_t i) const {
+    const uint8_t* const record =
+        data_ + kGameLogHeaderSize + i * kGameLogRecordSize;
+    uint64_t index = 0;
+    for (int j = 0; j < 8; ++j) index |= uint64_t{record[j]} << (8 * j);
+    uint32_t packed = 0;
+    for (int j = 0; j < 4; ++j) packed |= uint32_t{record[8 + j]} << (8 * j);
+    return {.index = index,
+            .winner = static_cast<Game::Winner>(packed & 3),
+            .num_steps = packed >> 2};
+  }
+
+ private:
+  MappedGameLog(const uint8_t* data, size_t mapped_size,
+                const GameLogHeader& header);
+
+  const uint8_t* data_;
+  size_t mapped_size_;
+  GameLogHeader header_;
+  size_t size_;
+};
+
+}  // namespace bataille
+
+#endif  // GAME_LOG_H
@@ -0,0 +1,95 @@
+#include "game_log.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+TEST(GameLogTest, RoundTrip) {
+  const std::string path = testing::TempDir() + "/round_trip.log";
+  const GameLogHeader header = {.deck = {.colors = 4, .values = 13},
+                                .strategy = Strategy::kOptimized,
+                                .exhaustive = false,
+                                .seed = 1234,
+                                .rng = Rng::kXoshiro256StarStar};
+  // More records than fit in a block, from two threads.
+  constexpr uint64_t kNumRecords = GameLogWriter::kRecordsPerBlock + 10;
+  {
+    GameLogWriter writer(path, header);
+    ASSERT_TRUE(writer.ok());
+    std::vector<std::thread> threads;
+    for (unsigned thread = 0; thread < 2; ++thread) {
+      threads.emplace_back([&, thread] {
+        GameLogWriter::Buffer buffer(writer);
+        for (uint64_t i = 0; i < kNumRecords; ++i) {
+          buffer.Add(RandomDealIndex(thread, i),
+                     {.winner = static_cast<Game::Winner>(i % 4),
+                      .num_steps = static_cast<unsigned>(i * 7)});
+        }
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    EXPECT_TRUE(writer.Close());
+  }
+
+  const auto log = MappedGameLog::Open(path);
+  ASSERT_TRUE(log);
+  EXPECT_EQ(log->header().deck.colors, 4);
+  EXPECT_EQ(log->header().deck.values, 13);
+  EXPECT_EQ(log->header().strategy, Strategy::kOptimized);
+  EXPECT_FALSE(log->header().exhaustive);
+  EXPECT_EQ(log->header().seed, 1234);
+  EXPECT_EQ(log->header().rng, Rng::kXoshiro256StarStar);
+  ASSERT_EQ(log->size(), 2 * kNumRecords);
+  // Records of each thread are in order.
+  std::vector<uint64_t> next(2, 0);
+  for (size_t j = 0; j < log->size(); ++j) {
+    const GameLogRecord record = (*log)[j];
+    const unsigned thread = record.index >> 48;
+    ASSERT_LT(thread, 2);
+    const uint64_t i = next[thread]++;
+    ASSERT_EQ(record.index, RandomDealIndex(thread, i));
+    ASSERT_EQ(record.winner, static_cast<Game::Winner>(i % 4));
+    ASSERT_EQ(record.num_steps, i * 7);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(GameLogTest, IgnoresTruncatedRecord) {
+  const std::string path = testing::TempDir() + "/truncated.log";
+  {
+    GameLogWriter writer(path, {.deck = {.colors = 1, .values = 5}});
+    GameLogWriter::Buffer buffer(writer);
+    buffer.Add(3, {.winner = Game::Winner::kCycle, .num_steps = 8});
+    buffer.Add(4, {.winner = Game::Winner::kLeft, .num_steps = 5});
+  }
+  std::ofstream(path, std::ios::binary | std::ios::app) << "abc";
+
+  const auto log = MappedGameLog::Open(path);
+  ASSERT_TRUE(log);
+  EXPECT_TRUE(log->header().exhaustive);
+  ASSERT_EQ(log->size(), 2);
+  EXPECT_EQ((*log)[0].index, 3);
+  EXPECT_EQ((*log)[0].winner, Game::Winner::kCycle);
+  EXPECT_EQ((*log)[0].num_steps, 8);
+  EXPECT_EQ((*log)[1].index, 4);
+  EXPECT_EQ((*log)[1].winner, Game::Winner::kLeft);
+  std::remove(path.c_str());
+}
+
+TEST(GameLogTest, RejectsOtherFiles) {
+  const std::string path = testing::TempDir() + "/not_a_log";
+  std::ofstream(path) << "exhaustive exploration C=4 V=5\n\n";
+  EXPECT_FALSE(MappedGameLog::Open(path));
+  EXPECT_FALSE(MappedGameLog::Open(testing::TempDir() + "/missing.log"));
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace bataille
@@ -0,0 +1,28 @@
+#include "instrument.h"
+
+#include <ostream>
+
+namespace bataille {
+
+void InstrumentCounters::Merge(const InstrumentCounters& other) {
+  rounds += other.rounds;
+  tie_depths.Merge(other.tie_depths);
+  for (size_t i = 0; i < push_sizes.size(); ++i) {
+    push_sizes[i].Merge(other.push_sizes[i]);
+  }
+  left_hand_sizes.Merge(other.left_hand_sizes);
+  collision_steps.Merge(other.collision_steps);
+  cycle_periods.Merge(other.cycle_periods);
+}
+
+void InstrumentCounters::Print(std::ostream& os) const {
+  os << "rounds: " << rounds << "\n";
+  tie_depths.Print("ties", os);
+  push_sizes[0].Print("natural push size", os);
+  push_sizes[1].Print("optimized push size", os);
+  left_hand_sizes.Print("left hand size", os);
+  collision_steps.Print("collision steps", os);
+  cycle_periods.Print("cycle period", os);
+}
+
+}  // namespace bataille
@@ -0,0 +1,127 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace bataille {
+
+enum class Strategy;
+
+// Counts `value`s in buckets. Linear histograms have one bucket per value,
+// and the last bucket counts all larger values. Log2 histograms have one
+// bucket per power of two: bucket `b > 0` counts values in [2^(b-1), 2^b).
+template <size_t kNumBuckets, bool kLog2 = false>
+class Histogram {
+ public:
+  void Add(uint64_t value) {
+    const uint64_t bucket = kLog2 ? std::bit_width(value) : value;
+    ++buckets_[std::min<uint64_t>(bucket, kNumBuckets - 1)];
+  }
+
+  void Merge(const Histogram& other) {
+    for (size_t i = 0; i < kNumBuckets; ++i) buckets_[i] += other.buckets_[i];
+  }
+
+  uint64_t count(size_t bucket) const { return buckets_[bucket]; }
+
+  // Prints non-empty buckets as `name[value]: count`.
+  void Print(std::string_view name, std::ostream& os) const {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      if (buckets_[i] == 0) continue;
+      os << name << "[";
+      if (kLog2 && i > 1) {
+        os << (uint64_t{1} << (i - 1)) << "-" << (uint64_t{1} << i) - 1;
+      } else {
+        os << i;
+      }
+      os << (i == kNumBuckets - 1 ? "+" : "") << "]: " << buckets_[i] << "\n";
+    }
+  }
+
+ private:
+  std::array<uint64_t, kNumBuckets> buckets_ = {};
+};
+
+// Counters of what happens in the inner loops of the engines, for builds with
+// `-DBATAILLE_INSTRUMENT`. Each `GameArena` has its own counters, which the
+// engines reach through a thread-local pointer while the arena plays (see
+// `Scope`). Updates go through `BATAILLE_COUNT`, which compiles to nothing
+// without instrumentation.
+struct InstrumentCounters {
+  // Hand sizes are sampled every `kHandSizePeriod` rounds: a histogram update
+  // per round slows down long games by a third.
+  static constexpr unsigned kHandSizePeriod = 16;
+
+  // Rounds played, including rounds shared by several deals in batches.
+  uint64_t rounds = 0;
+  // The size of the left hand, sampled in runs of rounds of engines that play
+  // one game at a time.
+  Histogram<128> left_hand_sizes;
+  // Rounds with ties, by number of tied battles.
+  Histogram<16> tie_depths;
+  // Cards given to the winner of a round with ties, by strategy.
+  std::array<Histogram<32>, 2> push_sizes;
+  // The rounds played by the cycle detector until the collision point.
+  Histogram<33, true> collision_steps;
+  // The periods of cycles.
+  Histogram<33, true> cycle_periods;
+
+  void Rounds(uint64_t num_rounds) { rounds += num_rounds; }
+
+  // Records the ties of a round, which gives `2 * num_ties + 2` cards.
+  void Ties(unsigned num_ties, Strategy strategy) {
+    if (num_ties == 0) return;
+    tie_depths.Add(num_ties);
+    push_sizes[static_cast<int>(strategy)].Add(2 * num_ties + 2);
+  }
+
+  void Merge(const InstrumentCounters& other);
+  void Print(std::ostream& os) const;
+
+  // The counters of the current thread, or null.
+  static InstrumentCounters* Current() { return current_; }
+
+  // Makes `counters` the counters of the current thread, until destroyed.
+  class Scope {
+   public:
+    explicit Scope(InstrumentCounters* counters) : previous_(current_) {
+      current_ = counters;
+    }
+    ~Scope() { current_ = previous_; }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    InstrumentCounters* const previous_;
+  };
+
+ private:
+  static inline thread_local InstrumentCounters* current_ = nullptr;
+};
+
+}  // namespace bataille
+
+// `BATAILLE_COUNT(Rounds(n))` calls `Rounds(n)` on the counters of the
+// current thread, if any. Arguments are not evaluated without
+// instrumentation.
+#ifdef BATAILLE_INSTRUMENT
+#define BATAILLE_COUNT(...)                                     \
+  do {                                                          \
+    if (::bataille::InstrumentCounters* const bataille_counters = \
+            ::bataille::InstrumentCounters::Current()) {        \
+      bataille_counters->__VA_ARGS__;                           \
+    }                                                           \
+  } while (0)
+#else
+#define BATAILLE_COUNT(...) \
+  do {                      \
+  } while (0)
+#endif
+
+#endif  // INSTRUMENT_H
@@ -0,0 +1,83 @@
+#include "instrument.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "bataille.h"
+
+namespace bataille {
+namespace {
+
+TEST(HistogramTest, Linear) {
+  Histogram<4> histogram;
+  for (const uint64_t value : {0, 1, 1, 3, 4, 100}) histogram.Add(value);
+  EXPECT_EQ(histogram.count(0), 1);
+  EXPECT_EQ(histogram.count(1), 2);
+  EXPECT_EQ(histogram.count(2), 0);
+  EXPECT_EQ(histogram.count(3), 3);
+  std::ostringstream os;
+  histogram.Print("h", os);
+  EXPECT_EQ(os.str(), "h[0]: 1\nh[1]: 2\nh[3+]: 3\n");
+}
+
+TEST(HistogramTest, Log2) {
+  Histogram<4, true> histogram;
+  for (const uint64_t value : {0, 1, 2, 3, 4, 7, 8, 1000}) histogram.Add(value);
+  EXPECT_EQ(histogram.count(0), 1);
+  EXPECT_EQ(histogram.count(1), 1);
+  EXPECT_EQ(histogram.count(2), 2);
+  EXPECT_EQ(histogram.count(3), 4);
+  std::ostringstream os;
+  histogram.Print("h", os);
+  EXPECT_EQ(os.str(), "h[0]: 1\nh[1]: 1\nh[2-3]: 2\nh[4-7+]: 4\n");
+}
+
+TEST(InstrumentCountersTest, CountAndMerge) {
+  InstrumentCounters counters;
+  counters.left_hand_sizes.Add(3);
+  counters.left_hand_sizes.Add(3);
+  counters.left_hand_sizes.Add(5);
+  counters.Rounds(12);
+  counters.Ties(0, Strategy::kNatural);
+  counters.Ties(2, Strategy::kOptimized);
+  EXPECT_EQ(counters.rounds, 12);
+  EXPECT_EQ(counters.left_hand_sizes.count(3), 2);
+  EXPECT_EQ(counters.left_hand_sizes.count(5), 1);
+  EXPECT_EQ(counters.tie_depths.count(0), 0);
+  EXPECT_EQ(counters.tie_depths.count(2), 1);
+  EXPECT_EQ(counters.push_sizes[1].count(6), 1);
+
+  InstrumentCounters merged;
+  merged.Merge(counters);
+  merged.Merge(counters);
+  EXPECT_EQ(merged.rounds, 24);
+  EXPECT_EQ(merged.push_sizes[1].count(6), 2);
+  std::ostringstream os;
+  merged.Print(os);
+  EXPECT_EQ(os.str(),
+            "rounds: 24\n"
+            "ties[2]: 2\n"
+            "optimized push size[6]: 2\n"
+            "left hand size[3]: 4\n"
+            "left hand size[5]: 2\n");
+}
+
+TEST(InstrumentCountersTest, Scope) {
+  EXPECT_EQ(InstrumentCounters::Current(), nullptr);
+  InstrumentCounters outer;
+  InstrumentCounters inner;
+  {
+    const InstrumentCounters::Scope outer_scope(&outer);
+    EXPECT_EQ(InstrumentCounters::Current(), &outer);
+    {
+      const InstrumentCounters::Scope inner_scope(&inner);
+      EXPECT_EQ(InstrumentCounters::Current(), &inner);
+    }
+    EXPECT_EQ(InstrumentCounters::Current(), &outer);
+  }
+  EXPECT_EQ(InstrumentCounters::Current(), nullptr);
+}
+
+}  // namespace
+}  // namespace bataille
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "bataille.h"
+#include "game_log.h"
+#include "instrument.h"
+
+using bataille::Game;
+using bataille::GameLogHeader;
+using bataille::MappedGameLog;
+
+// Prints the distribution of game lengths and winners in the game logs written
+// by `explore --log`.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << argv[0] << " LOG...\n";
+    return 1;
+  }
+  for (int i = 1; i < argc; ++i) {
+    const auto log = MappedGameLog::Open(argv[i]);
+    if (!log) {
+      std::cerr << "cannot read game log " << argv[i] << "\n";
+      return 1;
+    }
+    const GameLogHeader& header = log->header();
+    std::cout << argv[i] << ": "
+              << (header.exhaustive ? "exhaustive" : "random")
+              << " exploration C=" << header.deck.colors
+              << " V=" << header.deck.values << " "
+              << bataille::StrategyName(header.strategy);
+    if (!header.exhaustive) {
+      std::cout << " seed=" << header.seed
+                << " rng=" << bataille::RngName(header.rng);
+    }
+    std::cout << "\n";
+
+    std::array<uint64_t, 4> num_wins = {};
+    std::array<uint64_t, 4> sum_steps = {};
+    std::array<unsigned, 4> max_steps = {};
+    bataille::Histogram<33, true> end_steps;
+    bataille::Histogram<33, true> cycle_steps;
+    for (size_t j = 0; j < log->size(); ++j) {
+      const bataille::GameLogRecord record = (*log)[j];
+      const int winner = static_cast<int>(record.winner);
+      ++num_wins[winner];
+      sum_steps[winner] += record.num_steps;
+      max_steps[winner] = std::max(max_steps[winner], record.num_steps);
+      (record.winner == Game::Winner::kCycle ? cycle_steps : end_steps)
+          .Add(record.num_steps);
+    }
+
+    std::cout << "games: " << log->size() << "\n";
+    constexpr std::array<const char*, 4> kWinnerNames = {"left", "right",
+                                                         "draw", "cycle"};
+    for (int winner = 0; winner < 4; ++winner) {
+      if (num_wins[winner] == 0) continue;
+      std::cout << kWinnerNames[winner] << ": " << num_wins[winner] << " ("
+                << 100.0 * num_wins[winner] / log->size()
+                << "%), mean steps "
+                << static_cast<double>(sum_steps[winner]) / num_wins[winner]
+                << ", max steps " << max_steps[winner] << "\n";
+    }
+    end_steps.Print("steps", std::cout);
+    cycle_steps.Print("cycle steps", std::cout);
+  }
+  return 0;
+}
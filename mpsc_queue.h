@@ -0,0 +1,63 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace bataille {
+
+// An unbounded lock-free queue with many producers and a single consumer
+// (Vyukov's intrusive MPSC queue). `Push` is wait-free: one allocation and one
+// atomic exchange. `TryPop` must only be called by one thread at a time.
+// `T` must be default-constructible (the queue keeps a placeholder node).
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(new Node), tail_(head_.load()) {}
+  ~MpscQueue() {
+    while (tail_ != nullptr) {
+      Node* const next = tail_->next.load(std::memory_order_relaxed);
+      delete tail_;
+      tail_ = next;
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void Push(T value) {
+    Node* const node = new Node;
+    node->value = std::move(value);
+    Node* const prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Returns the oldest value, or std::nullopt if the queue is empty. A value
+  // whose `Push` has not returned yet may not be visible, nor the values
+  // pushed after it.
+  std::optional<T> TryPop() {
+    Node* const next = tail_->next.load(std::memory_order_acquire);
+    if (next == nullptr) return std::nullopt;
+    // `next` becomes the placeholder.
+    std::optional<T> value(std::move(next->value));
+    delete tail_;
+    tail_ = next;
+    return value;
+  }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next = nullptr;
+    T value;
+  };
+
+  // The last pushed node, written by producers.
+  alignas(64) std::atomic<Node*> head_;
+  // The placeholder node before the oldest value, only used by the consumer.
+  alignas(64) Node* tail_;
+};
+
+}  // namespace bataille
+
+#endif  // MPSC_QUEUE_H
@@ -0,0 +1,55 @@
+#include "mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+TEST(MpscQueueTest, Fifo) {
+  MpscQueue<int> queue;
+  EXPECT_EQ(queue.TryPop(), std::nullopt);
+  queue.Push(1);
+  queue.Push(2);
+  EXPECT_EQ(queue.TryPop(), 1);
+  queue.Push(3);
+  EXPECT_EQ(queue.TryPop(), 2);
+  EXPECT_EQ(queue.TryPop(), 3);
+  EXPECT_EQ(queue.TryPop(), std::nullopt);
+}
+
+TEST(MpscQueueTest, FreesRemainingValues) {
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.Push(std::make_unique<int>(1));
+  queue.Push(std::make_unique<int>(2));
+  EXPECT_EQ(*queue.TryPop().value(), 1);
+}
+
+TEST(MpscQueueTest, ManyProducers) {
+  constexpr int kNumProducers = 4;
+  constexpr int kNumValues = 100000;
+  MpscQueue<std::pair<int, int>> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kNumProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kNumValues; ++i) queue.Push({p, i});
+    });
+  }
+  // Values of each producer come out in order, while they are pushed.
+  std::vector<int> next(kNumProducers, 0);
+  for (int n = 0; n < kNumProducers * kNumValues;) {
+    const auto value = queue.TryPop();
+    if (!value) continue;
+    const auto [p, i] = *value;
+    ASSERT_EQ(i, next[p]++);
+    ++n;
+  }
+  for (std::thread& producer : producers) producer.join();
+  EXPECT_EQ(queue.TryPop(), std::nullopt);
+}
+
+}  // namespace
+}  // namespace bataille
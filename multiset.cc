@@ -0,0 +1,158 @@
+#include "multiset.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+
+namespace bataille {
+namespace {
+
+__extension__ typedef unsigned __int128 uint128;
+
+// The distinct values of a multiset of cards in increasing order, with their
+// multiplicities.
+struct Counts {
+  explicit Counts(std::span<const Card> cards) {
+    std::array<unsigned, std::numeric_limits<Card>::max() + 1> counts = {};
+    for (const Card c : cards) ++counts[c];
+    for (unsigned v = 0; v < counts.size(); ++v) {
+      if (counts[v] > 0) {
+        values[num_values] = v;
+        multiplicities[num_values] = counts[v];
+        ++num_values;
+      }
+    }
+  }
+
+  std::array<Card, std::numeric_limits<Card>::max() + 1> values;
+  std::array<unsigned, std::numeric_limits<Card>::max() + 1> multiplicities;
+  unsigned num_values = 0;
+};
+
+// Rearranges `right` into its smallest permutation that is not smaller
+// (lexicographically) than `left`, which has the same size. Returns false if
+// there is none.
+bool RearrangeNotBelow(std::span<const Card> left, std::span<Card> right) {
+  std::array<unsigned, std::numeric_limits<Card>::max() + 1> counts = {};
+  for (const Card c : right) ++counts[c];
+  const unsigned max_card = *std::max_element(right.begin(), right.end());
+  // Follow `left` as long as the cards of `right` allow it. The result is
+  // either `left` itself, or branches off with a larger card at the deepest
+  // position where one is available.
+  std::optional<size_t> branch;
+  size_t i = 0;
+  for (; i < left.size(); ++i) {
+    for (unsigned c = left[i] + 1; c <= max_card; ++c) {
+      if (counts[c] > 0) {
+        branch = i;
+        break;
+      }
+    }
+    if (counts[left[i]] == 0) break;
+    --counts[left[i]];
+  }
+  if (i == left.size()) {
+    std::copy(left.begin(), left.end(), right.begin());
+    return true;
+  }
+  if (!branch) return false;
+  for (size_t k = *branch; k < i; ++k) ++counts[left[k]];
+  std::copy(left.begin(), left.begin() + *branch, right.begin());
+  unsigned c = left[*branch] + 1;
+  while (counts[c] == 0) ++c;
+  right[*branch] = c;
+  --counts[c];
+  // The other cards follow in increasing order.
+  auto it = right.begin() + *branch + 1;
+  for (c = 0; c <= max_card; ++c) it = std::fill_n(it, counts[c], c);
+  return true;
+}
+
+}  // namespace
+
+uint64_t NumPermutations(std::span<const Card> cards) {
+  const Counts counts(cards);
+  // Every intermediate value is a multinomial coefficient, so the divisions
+  // are exact.
+  uint128 result = 1;
+  unsigned m = 0;
+  for (unsigned i = 0; i < counts.num_values; ++i) {
+    for (unsigned j = 1; j <= counts.multiplicities[i]; ++j) {
+      ++m;
+      result = result * m / j;
+      if (result > std::numeric_limits<uint64_t>::max()) {
+        return std::numeric_limits<uint64_t>::max();
+      }
+    }
+  }
+  return result;
+}
+
+uint64_t Rank(std::span<const Card> cards) {
+  Counts counts(cards);
+  // `num_perms` is the number of permutations of the remaining cards.
+  uint128 num_perms = NumPermutations(cards);
+  assert(num_perms < std::numeric_limits<uint64_t>::max());
+  uint64_t rank = 0;
+  unsigned m = cards.size();
+  for (const Card card : cards) {
+    unsigned i = 0;
+    // All permutations starting with a smaller card come first.
+    for (; counts.values[i] < card; ++i) {
+      rank += num_perms * counts.multiplicities[i] / m;
+    }
+    assert(counts.values[i] == card);
+    num_perms = num_perms * counts.multiplicities[i] / m;
+    --counts.multiplicities[i];
+    --m;
+  }
+  return rank;
+}
+
+void Unrank(uint64_t rank, std::span<Card> cards) {
+  Counts counts(cards);
+  uint128 num_perms = NumPermutations(cards);
+  assert(rank < num_perms);
+  unsigned m = cards.size();
+  for (Card& card : cards) {
+    unsigned i = 0;
+    for (;; ++i) {
+      const uint64_t block = num_perms * counts.multiplicities[i] / m;
+      if (rank < block) break;
+      rank -= block;
+    }
+    card = counts.values[i];
+    num_perms = num_perms * counts.multiplicities[i] / m;
+    --counts.multiplicities[i];
+    --m;
+  }
+}
+
+uint64_t SkipToCanonicalDeal(std::span<Card> cards) {
+  if (cards.size() % 2 != 0) return 0;
+  const size_t half = cards.size() / 2;
+  const std::span<const Card> left = cards.first(half);
+  const std::span<Card> right = cards.subspan(half);
+  uint64_t skipped = 0;
+  // For a given left hand, the deals are in the order of the permutations of
+  // the right hand, and have consecutive ranks. The deals that are not
+  // canonical are those with a right hand smaller than the left hand, so they
+  // come first.
+  while (!IsCanonicalDeal(cards)) {
+    const uint64_t rank = Rank(right);
+    if (RearrangeNotBelow(left, right)) return skipped + Rank(right) - rank;
+    // No right hand is large enough: go to the next left hand, whose first
+    // right hand is sorted.
+    skipped += NumPermutations(right) - rank;
+    std::sort(right.begin(), right.end(), std::greater<>());
+    if (!std::next_permutation(cards.begin(), cards.end())) break;
+  }
+  return skipped;
+}
+
+}  // namespace bataille
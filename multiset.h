@@ -0,0 +1,36 @@
+#ifndef MULTISET_H
+#define MULTISET_H
+
+#include <cstdint>
+#include <span>
+
+#include "bataille.h"
+
+namespace bataille {
+
+// Ranking of the permutations of a multiset of cards, in lexicographic order
+// (i.e. the order in which `std::next_permutation` enumerates them).
+
+// Returns the number of distinct permutations of `cards`, or
+// `std::numeric_limits<uint64_t>::max()` if that does not fit in 64 bits.
+uint64_t NumPermutations(std::span<const Card> cards);
+
+// Returns the lexicographic rank of `cards` among the permutations of its
+// multiset. The sorted permutation has rank 0.
+uint64_t Rank(std::span<const Card> cards);
+
+// Rearranges `cards` (any permutation of the multiset) into the permutation of
+// rank `rank`. Precondition: rank < NumPermutations(cards).
+void Unrank(uint64_t rank, std::span<Card> cards);
+
+// Rearranges `cards` into the first canonical deal (see `IsCanonicalDeal`)
+// that does not come before it in lexicographic order, and returns the
+// difference of their ranks. If there is none, rearranges `cards` into the
+// sorted permutation and returns `NumPermutations(cards) - Rank(cards)`, so
+// that the rank reached is one past the last permutation.
+// Precondition: NumPermutations(cards) fits in 64 bits.
+uint64_t SkipToCanonicalDeal(std::span<Card> cards);
+
+}  // namespace bataille
+
+#endif  // MULTISET_H
@@ -0,0 +1,102 @@
+#include "multiset.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+TEST(MultisetTest, NumPermutations) {
+  EXPECT_EQ(NumPermutations(Deck::Seq(5).Make()), 120);
+  EXPECT_EQ(NumPermutations(Deck{.colors = 2, .values = 3}.Make()), 90);
+  EXPECT_EQ(NumPermutations(Deck{.colors = 4, .values = 5}.Make()),
+            305540235000ull);
+  EXPECT_EQ(NumPermutations(Deck::Standard54().Make()),
+            std::numeric_limits<uint64_t>::max());
+}
+
+TEST(MultisetTest, RankFollowsNextPermutation) {
+  const Deck deck{.colors = 2, .values = 4};
+  std::vector<Card> cards = deck.Make();
+  uint64_t rank = 0;
+  do {
+    EXPECT_EQ(Rank(cards), rank);
+    std::vector<Card> unranked = deck.Make();
+    Unrank(rank, unranked);
+    EXPECT_EQ(unranked, cards);
+    ++rank;
+  } while (std::next_permutation(cards.begin(), cards.end()));
+  EXPECT_EQ(rank, NumPermutations(cards));
+}
+
+TEST(MultisetTest, LargeRanks) {
+  const Deck deck{.colors = 4, .values = 6};
+  const uint64_t num_perms = NumPermutations(deck.Make());
+  for (const uint64_t rank : {uint64_t{0}, uint64_t{1}, uint64_t{123456789},
+                              num_perms / 2, num_perms - 1}) {
+    std::vector<Card> cards = deck.Make();
+    Unrank(rank, cards);
+    EXPECT_EQ(Rank(cards), rank);
+  }
+  std::vector<Card> cards = deck.Make();
+  Unrank(num_perms - 1, cards);
+  EXPECT_TRUE(std::is_sorted(cards.begin(), cards.end(), std::greater<>()));
+}
+
+// Checks that skipping to canonical deals from any deal reaches the next
+// canonical deal in lexicographic order, or one past the last permutation.
+void ExpectSkipsToCanonicalDeals(Deck deck) {
+  std::vector<Card> cards = deck.Make();
+  const uint64_t num_perms = NumPermutations(cards);
+  // The rank of the next canonical deal, for each rank.
+  std::vector<uint64_t> next_canonical(num_perms + 1, num_perms);
+  std::vector<std::vector<Card>> deals(num_perms);
+  for (uint64_t rank = 0; rank < num_perms; ++rank) {
+    deals[rank] = cards;
+    std::next_permutation(cards.begin(), cards.end());
+  }
+  for (uint64_t rank = num_perms; rank-- > 0;) {
+    next_canonical[rank] =
+        IsCanonicalDeal(deals[rank]) ? rank : next_canonical[rank + 1];
+  }
+  for (uint64_t rank = 0; rank < num_perms; ++rank) {
+    cards = deals[rank];
+    const uint64_t next = rank + SkipToCanonicalDeal(cards);
+    ASSERT_EQ(next, next_canonical[rank]) << "rank " << rank;
+    EXPECT_EQ(cards, next < num_perms ? deals[next] : deck.Make());
+  }
+}
+
+TEST(MultisetTest, SkipToCanonicalDeal) {
+  ExpectSkipsToCanonicalDeals(Deck::Seq(5));
+  ExpectSkipsToCanonicalDeals(Deck::Seq(6));
+  ExpectSkipsToCanonicalDeals({.colors = 2, .values = 3});
+  ExpectSkipsToCanonicalDeals({.colors = 2, .values = 4});
+  ExpectSkipsToCanonicalDeals({.colors = 3, .values = 2});
+  ExpectSkipsToCanonicalDeals({.colors = 4, .values = 2});
+}
+
+TEST(MultisetTest, EnumeratesCanonicalDeals) {
+  const Deck deck{.colors = 2, .values = 4};
+  std::vector<Card> cards = deck.Make();
+  std::vector<uint64_t> expected;
+  uint64_t rank = 0;
+  do {
+    if (IsCanonicalDeal(cards)) expected.push_back(rank);
+    ++rank;
+  } while (std::next_permutation(cards.begin(), cards.end()));
+  std::vector<uint64_t> ranks;
+  for (rank = SkipToCanonicalDeal(cards); rank < NumPermutations(cards);) {
+    ranks.push_back(rank);
+    EXPECT_EQ(Rank(cards), rank);
+    std::next_permutation(cards.begin(), cards.end());
+    rank += 1 + SkipToCanonicalDeal(cards);
+  }
+  EXPECT_EQ(ranks, expected);
+}
+
+}  // namespace
+}  // namespace bataille
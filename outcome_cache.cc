@@ -0,0 +1,54 @@
+#include "outcome_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <optional>
+
+namespace bataille {
+namespace {
+
+// Data layout: bit 63 is set for valid entries, bits 62-61 hold the winner,
+// bits 31-0 the number of steps.
+constexpr uint64_t kValid = uint64_t{1} << 63;
+
+uint64_t Encode(const OutcomeCache::Outcome& outcome) {
+  return kValid | (static_cast<uint64_t>(outcome.winner) << 61) |
+         outcome.num_steps;
+}
+
+OutcomeCache::Outcome Decode(uint64_t data) {
+  return {.winner = static_cast<Game::Winner>((data >> 61) & 3),
+          .num_steps = static_cast<unsigned>(data)};
+}
+
+}  // namespace
+
+OutcomeCache::OutcomeCache(size_t max_bytes)
+    : mask_(std::bit_floor(std::max(max_bytes / sizeof(Entry), size_t{1})) -
+            1),
+      entries_(std::make_unique<Entry[]>(mask_ + 1)) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    entries_[i].check.store(0, std::memory_order_relaxed);
+    entries_[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::optional<OutcomeCache::Outcome> OutcomeCache::Lookup(
+    const StateKey& key) const {
+  const Entry& entry = entries_[key.h2() & mask_];
+  const uint64_t data = entry.data.load(std::memory_order_relaxed);
+  const uint64_t check = entry.check.load(std::memory_order_relaxed);
+  if ((data & kValid) == 0 || (check ^ data) != key.h1()) return std::nullopt;
+  return Decode(data);
+}
+
+void OutcomeCache::Insert(const StateKey& key, const Outcome& outcome) {
+  Entry& entry = entries_[key.h2() & mask_];
+  const uint64_t data = Encode(outcome);
+  entry.data.store(data, std::memory_order_relaxed);
+  entry.check.store(key.h1() ^ data, std::memory_order_relaxed);
+}
+
+}  // namespace bataille
@@ -0,0 +1,49 @@
+#ifndef OUTCOME_CACHE_H
+#define OUTCOME_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "bataille.h"
+
+namespace bataille {
+
+// A fixed-size table from game states to their known outcome, shared by all
+// threads exploring a deck with a given strategy. Entries are lock-free: each
+// one is a pair of 64-bit words (check, data) with check = key ^ data, so a
+// torn read is detected as a miss (Hyatt's lockless hashing). Colliding
+// entries are overwritten.
+class OutcomeCache {
+ public:
+  // The outcome of the game from a given state.
+  struct Outcome {
+    Game::Winner winner;
+    // For `kCycle`, the period of the cycle that the game ends up in.
+    // Otherwise, the number of rounds until the end of the game.
+    unsigned num_steps;
+  };
+
+  // Creates a cache that uses at most `max_bytes` of memory.
+  explicit OutcomeCache(size_t max_bytes);
+
+  std::optional<Outcome> Lookup(const StateKey& key) const;
+  void Insert(const StateKey& key, const Outcome& outcome);
+
+  size_t num_entries() const { return mask_ + 1; }
+
+ private:
+  struct Entry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  };
+
+  const size_t mask_;
+  const std::unique_ptr<Entry[]> entries_;
+};
+
+}  // namespace bataille
+
+#endif  // OUTCOME_CACHE_H
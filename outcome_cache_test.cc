@@ -0,0 +1,67 @@
+#include "outcome_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+StateKey Key(uint64_t value) {
+  StateKey key;
+  key.Add(value);
+  return key;
+}
+
+TEST(OutcomeCacheTest, InsertLookup) {
+  OutcomeCache cache(1 << 20);
+  EXPECT_EQ(cache.num_entries(), (1 << 20) / 16);
+  EXPECT_FALSE(cache.Lookup(Key(1)));
+  cache.Insert(Key(1), {.winner = Game::Winner::kRight, .num_steps = 42});
+  cache.Insert(Key(2), {.winner = Game::Winner::kCycle, .num_steps = 7});
+  const auto outcome = cache.Lookup(Key(1));
+  ASSERT_TRUE(outcome);
+  EXPECT_EQ(outcome->winner, Game::Winner::kRight);
+  EXPECT_EQ(outcome->num_steps, 42);
+  ASSERT_TRUE(cache.Lookup(Key(2)));
+  EXPECT_EQ(cache.Lookup(Key(2))->winner, Game::Winner::kCycle);
+  EXPECT_FALSE(cache.Lookup(Key(3)));
+}
+
+TEST(OutcomeCacheTest, Overwrites) {
+  // A single entry.
+  OutcomeCache cache(16);
+  ASSERT_EQ(cache.num_entries(), 1);
+  cache.Insert(Key(1), {.winner = Game::Winner::kLeft, .num_steps = 1});
+  cache.Insert(Key(2), {.winner = Game::Winner::kLeft, .num_steps = 2});
+  EXPECT_FALSE(cache.Lookup(Key(1)));
+  ASSERT_TRUE(cache.Lookup(Key(2)));
+  EXPECT_EQ(cache.Lookup(Key(2))->num_steps, 2);
+}
+
+TEST(OutcomeCacheTest, SameResultsAsWithoutCache) {
+  for (const Deck deck : {Deck{.colors = 4, .values = 3}, Deck::Seq(9),
+                          Deck{.colors = 2, .values = 5}}) {
+    for (const Strategy strategy :
+         {Strategy::kNatural, Strategy::kOptimized}) {
+      OutcomeCache cache(1 << 20);
+      GameArena cached(deck);
+      cached.SetOutcomeCache(&cache);
+      GameArena arena(deck);
+      std::vector<Card> cards = deck.Make();
+      do {
+        const Game::Result expected = arena.Play(cards, strategy);
+        const Game::Result result = cached.Play(cards, strategy);
+        ASSERT_EQ(result.winner, expected.winner);
+        ASSERT_EQ(result.num_steps, expected.num_steps);
+        ASSERT_EQ(result.mu, expected.mu);
+        ASSERT_EQ(result.lambda, expected.lambda);
+      } while (std::next_permutation(cards.begin(), cards.end()));
+      EXPECT_GT(cached.stats().cache.hits, 0);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace bataille
@@ -0,0 +1,123 @@
+#include "prefix_snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "instrument.h"
+
+namespace bataille {
+
+PrefixSnapshot::PrefixSnapshot(Deck deck, uint32_t ring_capacity)
+    : num_cards_(deck.num_cards()),
+      num_left_(num_cards_ / 2),
+      num_right_(num_cards_ - num_left_),
+      capacity_(ring_capacity),
+      mask_(ring_capacity - 1),
+      num_shared_(num_left_ + (num_right_ > kNumUnshared
+                                   ? num_right_ - kNumUnshared
+                                   : 0)),
+      deal_(num_shared_),
+      snapshot_rings_(2 * ring_capacity),
+      game_rings_(2 * ring_capacity),
+      ties_(num_cards_) {
+  assert(capacity_ > num_cards_);
+  assert((capacity_ & mask_) == 0);
+}
+
+PrefixSnapshot::State PrefixSnapshot::Start(std::span<const Card> cards,
+                                             Strategy strategy, Card* left,
+                                             Card* right) {
+  assert(cards.size() == num_cards_);
+  // Deals share too few cards, just deal.
+  if (num_shared_ == num_left_) return Deal(cards, left, right);
+  // Rounds without a tie are the same with both strategies.
+  if (!has_snapshot_ || (strategy != strategy_ && snapshot_.tied) ||
+      memcmp(cards.data(), deal_.data(), num_shared_) != 0) {
+    TakeSnapshot(cards, strategy);
+  }
+  if (snapshot_.winner) return snapshot_;
+  memcpy(left, snapshot_rings_.data(), capacity_);
+  memcpy(right, snapshot_rings_.data() + capacity_, capacity_);
+  // Positions are not wrapped yet: the right player played fewer than
+  // `num_right_` cards.
+  memcpy(right + snapshot_.right_head,
+         cards.data() + num_left_ + snapshot_.right_head,
+         num_right_ - snapshot_.right_head);
+  return snapshot_;
+}
+
+PrefixSnapshot::State PrefixSnapshot::Deal(std::span<const Card> cards,
+                                            Card* left, Card* right) const {
+  assert(cards.size() == num_cards_);
+  memcpy(left, cards.data(), num_left_);
+  memcpy(right, cards.data() + num_left_, num_right_);
+  return {.left_len = num_left_, .right_len = num_right_};
+}
+
+void PrefixSnapshot::TakeSnapshot(std::span<const Card> cards,
+                                  Strategy strategy) {
+  std::copy(cards.begin(), cards.begin() + num_shared_, deal_.begin());
+  strategy_ = strategy;
+  has_snapshot_ = true;
+  game_ = {.left_len = num_left_, .right_len = num_right_};
+  std::copy(cards.begin(), cards.begin() + num_left_, game_rings_.begin());
+  std::copy(cards.begin() + num_left_, cards.end(),
+            game_rings_.begin() + capacity_);
+  // The right player plays its dealt cards in order, so the dealt card at
+  // `num_shared_` is at position `depth` in the right ring.
+  const unsigned depth = num_shared_ - num_left_;
+  while (true) {
+    snapshot_ = game_;
+    std::copy(game_rings_.begin(), game_rings_.end(),
+              snapshot_rings_.begin());
+    const bool over = Step(strategy);
+    if (game_.right_head > depth) return;
+    if (over) {
+      snapshot_ = game_;
+      snapshot_.winner = game_.left_len == 0
+                             ? (game_.right_len == 0 ? Game::Winner::kDraw
+                                                     : Game::Winner::kRight)
+                             : Game::Winner::kLeft;
+      return;
+    }
+  }
+}
+
+bool PrefixSnapshot::Step(Strategy strategy) {
+  Card* const l = game_rings_.data();
+  Card* const r = game_rings_.data() + capacity_;
+  State& g = game_;
+  ++g.steps;
+
+  unsigned num_ties = 0;
+  Card cl, cr;
+  do {
+    cl = l[g.left_head++ & mask_];
+    --g.left_len;
+    cr = r[g.right_head++ & mask_];
+    --g.right_len;
+    if (cl != cr) break;
+    ties_[num_ties++] = cl;
+  } while (g.left_len != 0 && g.right_len != 0);
+  BATAILLE_COUNT(Rounds(1));
+  g.tied |= num_ties > 0;
+  if (cl != cr) {
+    BATAILLE_COUNT(Ties(num_ties, strategy));
+    const std::span<Card> ties(ties_.data(), num_ties);
+    if (cr < cl) {
+      PushRoundCards(cl, cr, ties, strategy, [&](Card card) {
+        l[(g.left_head + g.left_len++) & mask_] = card;
+      });
+    } else {
+      PushRoundCards(cr, cl, ties, strategy, [&](Card card) {
+        r[(g.right_head + g.right_len++) & mask_] = card;
+      });
+    }
+  }
+  return g.left_len == 0 || g.right_len == 0;
+}
+
+}  // namespace bataille
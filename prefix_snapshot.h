@@ -0,0 +1,88 @@
+#ifndef PREFIX_SNAPSHOT_H
+#define PREFIX_SNAPSHOT_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "bataille.h"
+
+namespace bataille {
+
+// Shares the first rounds of games between deals that only differ by their
+// last cards.
+//
+// Until the right player plays its `j`-th dealt card, the game only depends on
+// the left hand and on the first `j` cards of the right hand: the other dealt
+// cards are at the top of the right hand, in order, above the cards won since.
+// Exhaustive explorations deal permutations in lexicographic order, so runs
+// of consecutive deals only differ by their last `kNumUnshared` cards. This
+// plays the first deal of each run until the right player is about to play one
+// of these cards, and starts the other games of the run from there, with the
+// unplayed dealt cards replaced. Deals in any other order (e.g. random deals)
+// almost never share a snapshot, and should use `Deal`.
+//
+// Hands are rings, as in `BatchEngine`.
+class PrefixSnapshot {
+ public:
+  // Deeper snapshots would be shared by too few deals to pay for the rounds
+  // played to compute them.
+  static constexpr unsigned kNumUnshared = 4;
+
+  // `ring_capacity` is a power of two, larger than the number of cards.
+  PrefixSnapshot(Deck deck, uint32_t ring_capacity);
+
+  // The state of a game after `steps` rounds. If `winner` is set, the game is
+  // over after `steps` rounds and there are no hands. Otherwise, the top card
+  // of the left hand is at `left[left_head & (ring_capacity - 1)]`, and so on.
+  struct State {
+    uint32_t left_head = 0;
+    uint32_t left_len = 0;
+    uint32_t right_head = 0;
+    uint32_t right_len = 0;
+    unsigned steps = 0;
+    std::optional<Game::Winner> winner = std::nullopt;
+    // Whether one of the `steps` rounds had a tie. Until then, the game is the
+    // same with both strategies.
+    bool tied = false;
+  };
+
+  // Writes a state of the game dealt with `cards` (as in `Game::Deal`) to the
+  // rings `left` and `right`, as deep into the game as the snapshot allows.
+  State Start(std::span<const Card> cards, Strategy strategy, Card* left,
+              Card* right);
+
+  // Writes the initial state of the game dealt with `cards` to the rings
+  // `left` and `right`, without looking at the snapshot.
+  State Deal(std::span<const Card> cards, Card* left, Card* right) const;
+
+ private:
+  // Plays `cards` until the right player is about to play the dealt card at
+  // `num_shared_` (or the game ends before), and saves that state.
+  void TakeSnapshot(std::span<const Card> cards, Strategy strategy);
+  // Plays a round of `game_`, returns true if the game is over.
+  bool Step(Strategy strategy);
+
+  const unsigned num_cards_;
+  const unsigned num_left_;
+  const unsigned num_right_;
+  const uint32_t capacity_;
+  const uint32_t mask_;
+  // Games of deals that agree on their first `num_shared_` cards share the
+  // snapshot. There is no snapshot if this is `num_left_`.
+  const unsigned num_shared_;
+  std::vector<Card> deal_;
+  Strategy strategy_ = Strategy::kNatural;
+  bool has_snapshot_ = false;
+  State snapshot_;
+  std::vector<Card> snapshot_rings_;
+
+  State game_;
+  std::vector<Card> game_rings_;
+  std::vector<Card> ties_;
+};
+
+}  // namespace bataille
+
+#endif  // PREFIX_SNAPSHOT_H
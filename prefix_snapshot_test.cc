@@ -0,0 +1,132 @@
+#include "prefix_snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bit>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+std::vector<Card> Cards(const Hand& hand) {
+  std::vector<Card> cards;
+  hand.AppendTo(cards);
+  return cards;
+}
+
+std::vector<Card> Cards(const Card* ring, uint32_t head, uint32_t len,
+                        uint32_t capacity) {
+  std::vector<Card> cards;
+  for (uint32_t i = 0; i < len; ++i) {
+    cards.push_back(ring[(head + i) & (capacity - 1)]);
+  }
+  return cards;
+}
+
+// Starts the games of `deals` in order, and checks that each state is the
+// state of the game after the same number of rounds, and whether these rounds
+// had a tie.
+void ExpectSameAsGame(Deck deck, const std::vector<Card>& deals,
+                      const std::vector<Strategy>& strategies) {
+  const unsigned n = deck.num_cards();
+  const uint32_t capacity = std::bit_ceil(n + 1);
+  PrefixSnapshot prefix(deck, capacity);
+  // Like lanes of `BatchEngine`, the rings are reused between games.
+  std::vector<Card> left(capacity);
+  std::vector<Card> right(capacity);
+  const std::span<const Card> all(deals);
+  const size_t num_deals = deals.size() / n;
+  for (size_t i = 0; i < num_deals; ++i) {
+    const std::span<const Card> cards = all.subspan(i * n, n);
+    const Strategy strategy = strategies[i % strategies.size()];
+    const PrefixSnapshot::State state =
+        prefix.Start(cards, strategy, left.data(), right.data());
+    Game game(deck);
+    game.Deal(cards);
+    bool tied = false;
+    for (unsigned step = 1; step < state.steps; ++step) {
+      tied |= game.left().Top() == game.right().Top();
+      ASSERT_FALSE(game.Step(strategy));
+    }
+    if (state.winner) {
+      tied |= game.left().Top() == game.right().Top();
+      ASSERT_TRUE(game.Step(strategy));
+      EXPECT_EQ(game.GetWinner(), *state.winner);
+      EXPECT_EQ(state.tied, tied);
+      continue;
+    }
+    if (state.steps > 0) {
+      tied |= game.left().Top() == game.right().Top();
+      ASSERT_FALSE(game.Step(strategy));
+    }
+    EXPECT_EQ(state.tied, tied);
+    EXPECT_EQ(Cards(game.left()), Cards(left.data(), state.left_head,
+                                        state.left_len, capacity));
+    EXPECT_EQ(Cards(game.right()), Cards(right.data(), state.right_head,
+                                         state.right_len, capacity));
+  }
+}
+
+std::vector<Card> AllDeals(Deck deck) {
+  std::vector<Card> deals;
+  std::vector<Card> cards = deck.Make();
+  do {
+    deals.insert(deals.end(), cards.begin(), cards.end());
+  } while (std::next_permutation(cards.begin(), cards.end()));
+  return deals;
+}
+
+TEST(PrefixSnapshotTest, AllDeals) {
+  for (const Deck deck : {Deck::Seq(7), Deck{.colors = 4, .values = 3},
+                          Deck{.colors = 2, .values = 4}}) {
+    ExpectSameAsGame(deck, AllDeals(deck), {Strategy::kNatural});
+    ExpectSameAsGame(deck, AllDeals(deck), {Strategy::kOptimized});
+  }
+}
+
+TEST(PrefixSnapshotTest, MixedStrategies) {
+  const Deck deck = {.colors = 4, .values = 3};
+  ExpectSameAsGame(deck, AllDeals(deck),
+                   {Strategy::kNatural, Strategy::kNatural,
+                    Strategy::kOptimized});
+}
+
+TEST(PrefixSnapshotTest, LongHands) {
+  // Deals share their first 12 cards, in lexicographic order as in
+  // exhaustive explorations.
+  const Deck deck = {.colors = 4, .values = 4};
+  std::vector<Card> cards = deck.Make();
+  std::vector<Card> deals;
+  for (int i = 0; i < 20000; ++i) {
+    deals.insert(deals.end(), cards.begin(), cards.end());
+    std::next_permutation(cards.begin(), cards.end());
+  }
+  ExpectSameAsGame(deck, deals, {Strategy::kNatural});
+  ExpectSameAsGame(deck, deals, {Strategy::kOptimized});
+}
+
+TEST(PrefixSnapshotTest, RandomDeals) {
+  const Deck deck = Deck::Standard32();
+  std::mt19937 gen(42);
+  std::vector<Card> cards = deck.Make();
+  std::vector<Card> deals;
+  for (int i = 0; i < 1000; ++i) {
+    // Mostly shuffle the bottom of the right hand.
+    std::shuffle(cards.begin() + (i % 5 == 0 ? 0 : 16 + i % 14), cards.end(),
+                 gen);
+    deals.insert(deals.end(), cards.begin(), cards.end());
+  }
+  ExpectSameAsGame(deck, deals, {Strategy::kNatural});
+}
+
+TEST(PrefixSnapshotTest, SameDealTwice) {
+  const Deck deck = Deck::Seq(6);
+  ExpectSameAsGame(deck, {1, 5, 3, 2, 6, 4, 1, 5, 3, 2, 6, 4},
+                   {Strategy::kNatural});
+}
+
+}  // namespace
+}  // namespace bataille
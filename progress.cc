@@ -0,0 +1,122 @@
+#include "progress.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+void WriteJsonCards(const std::vector<Card>& cards, std::ostream& os) {
+  os << "[";
+  for (size_t i = 0; i < cards.size(); ++i) {
+    os << (i == 0 ? "" : ",") << static_cast<int>(cards[i]);
+  }
+  os << "]";
+}
+
+}  // namespace
+
+Progress::Progress(const GameArena::Stats& initial, double num_games)
+    : deck_(initial.longest.deck()), num_games_(num_games) {
+  if (initial.longest_len > 0) {
+    longest_ = {.num_steps = initial.longest_len,
+                .cards = initial.longest.Cards()};
+  }
+  if (initial.shortest_with_cycle_len <
+      std::numeric_limits<unsigned>::max()) {
+    shortest_with_cycle_ = {.cycle = true,
+                            .num_steps = initial.shortest_with_cycle_len,
+                            .mu = initial.shortest_with_cycle_mu,
+                            .lambda = initial.shortest_with_cycle_lambda,
+                            .cards = initial.shortest_with_cycle.Cards()};
+  }
+}
+
+bool Progress::Update(GameArena::RecordQueue& queue) {
+  new_longest_ = false;
+  new_shortest_with_cycle_ = false;
+  // Each arena pushes its own records, which are not always records of the
+  // run.
+  while (std::optional<GameArena::RecordEvent> event = queue.TryPop()) {
+    if (event->cycle) {
+      if (!shortest_with_cycle_ ||
+          event->num_steps < shortest_with_cycle_->num_steps) {
+        shortest_with_cycle_ = std::move(event);
+        new_shortest_with_cycle_ = true;
+      }
+    } else if (event->num_steps > longest_len()) {
+      longest_ = std::move(event);
+      new_longest_ = true;
+    }
+  }
+  return new_longest_ || new_shortest_with_cycle_;
+}
+
+void Progress::PrintNewRecords(std::ostream& os) const {
+  Game game(deck_);
+  if (new_shortest_with_cycle_) {
+    game.Deal(shortest_with_cycle_->cards);
+    os << "new shortest game with cycle (" << shortest_with_cycle_->num_steps
+       << "): " << game.left().DebugString() << " "
+       << game.right().DebugString() << "\n";
+  }
+  if (new_longest_) {
+    game.Deal(longest_->cards);
+    os << "new longest game (" << longest_->num_steps
+       << "): " << game.left().DebugString() << " "
+       << game.right().DebugString() << "\n";
+  }
+}
+
+void Progress::WriteJson(uint64_t num_played,
+                         std::chrono::duration<double> elapsed,
+                         std::ostream& os) {
+  os << "{\"time\":" << elapsed.count() << ",\"games\":" << num_played;
+  if (first_num_played_ && elapsed > last_elapsed_) {
+    os << ",\"games_per_s\":"
+       << (num_played - last_num_played_) / (elapsed - last_elapsed_).count();
+  } else {
+    os << ",\"games_per_s\":null";
+  }
+  // The estimate uses the average speed since the first line.
+  if (first_num_played_ && num_games_ > 0 && num_played > *first_num_played_) {
+    const double speed = (num_played - *first_num_played_) /
+                         (elapsed - first_elapsed_).count();
+    os << ",\"eta_s\":" << std::max(0.0, num_games_ - num_played) / speed;
+  } else {
+    os << ",\"eta_s\":null";
+  }
+  os << ",\"longest\":";
+  if (longest_) {
+    os << "{\"steps\":" << longest_->num_steps << ",\"deal\":";
+    WriteJsonCards(longest_->cards, os);
+    os << "}";
+  } else {
+    os << "null";
+  }
+  os << ",\"shortest_cycle\":";
+  if (shortest_with_cycle_) {
+    os << "{\"steps\":" << shortest_with_cycle_->num_steps
+       << ",\"mu\":" << shortest_with_cycle_->mu
+       << ",\"lambda\":" << shortest_with_cycle_->lambda << ",\"deal\":";
+    WriteJsonCards(shortest_with_cycle_->cards, os);
+    os << "}";
+  } else {
+    os << "null";
+  }
+  os << "}\n";
+  if (!first_num_played_) {
+    first_num_played_ = num_played;
+    first_elapsed_ = elapsed;
+  }
+  last_num_played_ = num_played;
+  last_elapsed_ = elapsed;
+}
+
+}  // namespace bataille
@@ -0,0 +1,58 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+
+#include "bataille.h"
+
+namespace bataille {
+
+// The records and progress of an exploration, as seen by the thread that
+// reports them. Records come from the `RecordEvent`s of the arenas of the
+// workers (see `GameArena::SetRecordQueue`), so reporting them never stops the
+// games.
+class Progress {
+ public:
+  // `initial` has the stats of the run before it was resumed. `num_games` is
+  // the number of games of the run, or 0 if it never ends.
+  Progress(const GameArena::Stats& initial, double num_games);
+
+  // Applies the events of `queue`. Returns true if a record of the run was
+  // improved.
+  bool Update(GameArena::RecordQueue& queue);
+
+  // Prints the records improved by the last `Update`, one line each.
+  void PrintNewRecords(std::ostream& os) const;
+
+  // Writes a line of JSON with the number of games played (`num_played`, in
+  // total), the games per second since the previous line, the estimated time
+  // until all games are played, and the records.
+  void WriteJson(uint64_t num_played, std::chrono::duration<double> elapsed,
+                 std::ostream& os);
+
+  unsigned longest_len() const { return longest_ ? longest_->num_steps : 0; }
+  std::optional<unsigned> shortest_with_cycle_len() const {
+    if (!shortest_with_cycle_) return std::nullopt;
+    return shortest_with_cycle_->num_steps;
+  }
+
+ private:
+  const Deck deck_;
+  const double num_games_;
+  std::optional<GameArena::RecordEvent> longest_;
+  std::optional<GameArena::RecordEvent> shortest_with_cycle_;
+  bool new_longest_ = false;
+  bool new_shortest_with_cycle_ = false;
+  // At the first and previous lines of JSON.
+  std::optional<uint64_t> first_num_played_;
+  std::chrono::duration<double> first_elapsed_{0};
+  uint64_t last_num_played_ = 0;
+  std::chrono::duration<double> last_elapsed_{0};
+};
+
+}  // namespace bataille
+
+#endif  // PROGRESS_H
@@ -0,0 +1,100 @@
+#include "progress.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+using std::chrono::seconds;
+
+TEST(ProgressTest, FollowsRecordsOfArenas) {
+  const Deck deck = {.colors = 1, .values = 9};
+  GameArena::RecordQueue queue;
+  GameArena a(deck), b(deck);
+  a.SetRecordQueue(&queue);
+  b.SetRecordQueue(&queue);
+  Progress progress(GameArena::Stats(deck), 0);
+  EXPECT_FALSE(progress.Update(queue));
+
+  // Every deal of the deck, half in each arena.
+  std::vector<Card> cards = deck.Make();
+  bool in_a = true;
+  do {
+    (in_a ? a : b).Play(cards, Strategy::kNatural);
+    in_a = !in_a;
+  } while (std::next_permutation(cards.begin(), cards.end()));
+  EXPECT_TRUE(progress.Update(queue));
+  // The first records in lexicographic order, as in results/c1v9.txt.
+  EXPECT_EQ(progress.longest_len(), 28);
+  EXPECT_EQ(progress.shortest_with_cycle_len(), 20);
+  std::ostringstream os;
+  progress.PrintNewRecords(os);
+  EXPECT_EQ(os.str(),
+            "new shortest game with cycle (20): [1,2,3,7,] [4,8,9,6,5,]\n"
+            "new longest game (28): [1,2,3,8,] [6,5,4,7,9,]\n");
+}
+
+TEST(ProgressTest, StartsFromInitialStats) {
+  const Deck deck = {.colors = 1, .values = 5};
+  GameArena arena(deck);
+  arena.Play(std::vector<Card>{1, 2, 3, 4, 5}, Strategy::kNatural);
+  Progress progress(arena.stats(), 0);
+  EXPECT_EQ(progress.longest_len(), arena.stats().longest_len);
+  EXPECT_EQ(progress.shortest_with_cycle_len(), std::nullopt);
+
+  // Events that are not records of the run are ignored.
+  GameArena::RecordQueue queue;
+  queue.Push({.num_steps = 1, .cards = {1, 2, 3, 4, 5}});
+  EXPECT_FALSE(progress.Update(queue));
+}
+
+TEST(ProgressTest, WriteJson) {
+  const Deck deck = {.colors = 1, .values = 5};
+  Progress progress(GameArena::Stats(deck), 1000);
+  GameArena::RecordQueue queue;
+  queue.Push({.num_steps = 8, .cards = {1, 2, 3, 4, 5}});
+  queue.Push({.cycle = true,
+              .num_steps = 6,
+              .mu = 2,
+              .lambda = 4,
+              .cards = {5, 4, 3, 2, 1}});
+  progress.Update(queue);
+
+  std::ostringstream os;
+  progress.WriteJson(100, seconds(1), os);
+  progress.WriteJson(300, seconds(2), os);
+  progress.WriteJson(400, seconds(4), os);
+  EXPECT_EQ(os.str(),
+            "{\"time\":1,\"games\":100,\"games_per_s\":null,\"eta_s\":null,"
+            "\"longest\":{\"steps\":8,\"deal\":[1,2,3,4,5]},"
+            "\"shortest_cycle\":{\"steps\":6,\"mu\":2,\"lambda\":4,"
+            "\"deal\":[5,4,3,2,1]}}\n"
+            "{\"time\":2,\"games\":300,\"games_per_s\":200,\"eta_s\":3.5,"
+            "\"longest\":{\"steps\":8,\"deal\":[1,2,3,4,5]},"
+            "\"shortest_cycle\":{\"steps\":6,\"mu\":2,\"lambda\":4,"
+            "\"deal\":[5,4,3,2,1]}}\n"
+            "{\"time\":4,\"games\":400,\"games_per_s\":50,\"eta_s\":6,"
+            "\"longest\":{\"steps\":8,\"deal\":[1,2,3,4,5]},"
+            "\"shortest_cycle\":{\"steps\":6,\"mu\":2,\"lambda\":4,"
+            "\"deal\":[5,4,3,2,1]}}\n");
+}
+
+TEST(ProgressTest, WriteJsonWithoutRecords) {
+  Progress progress(GameArena::Stats({.colors = 1, .values = 5}), 0);
+  std::ostringstream os;
+  progress.WriteJson(0, seconds(1), os);
+  progress.WriteJson(10, seconds(2), os);
+  EXPECT_EQ(os.str(),
+            "{\"time\":1,\"games\":0,\"games_per_s\":null,\"eta_s\":null,"
+            "\"longest\":null,\"shortest_cycle\":null}\n"
+            "{\"time\":2,\"games\":10,\"games_per_s\":10,\"eta_s\":null,"
+            "\"longest\":null,\"shortest_cycle\":null}\n");
+}
+
+}  // namespace
+}  // namespace bataille
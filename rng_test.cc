@@ -0,0 +1,78 @@
+#include "rng.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+TEST(RngTest, Names) {
+  for (const Rng rng : {Rng::kMt19937, Rng::kXoshiro256StarStar}) {
+    EXPECT_EQ(ParseRng(RngName(rng)), rng);
+  }
+  EXPECT_EQ(ParseRng("xoshiro"), std::nullopt);
+}
+
+TEST(Xoshiro256StarStarTest, ReferenceOutput) {
+  // The output of the reference implementation from the state {1, 2, 3, 4}.
+  Xoshiro256StarStar gen;
+  std::istringstream("1 2 3 4") >> gen;
+  EXPECT_EQ(gen(), 11520);
+  EXPECT_EQ(gen(), 0);
+  EXPECT_EQ(gen(), 1509978240);
+  EXPECT_EQ(gen(), 1215971899390074240ull);
+}
+
+TEST(Xoshiro256StarStarTest, SaveAndRestore) {
+  Xoshiro256StarStar gen(42);
+  gen();
+  std::stringstream ss;
+  ss << gen;
+  Xoshiro256StarStar restored;
+  ss >> restored;
+  EXPECT_EQ(restored, gen);
+  EXPECT_EQ(restored(), gen());
+}
+
+TEST(Xoshiro256StarStarTest, Jump) {
+  Xoshiro256StarStar gen(42);
+  Xoshiro256StarStar jumped = gen;
+  jumped.Jump();
+  EXPECT_NE(jumped, gen);
+  Xoshiro256StarStar jumped_again(42);
+  jumped_again.Jump();
+  EXPECT_EQ(jumped_again, jumped);
+}
+
+TEST(ShuffleTest, UniformBelow) {
+  Xoshiro256StarStar gen(42);
+  std::array<int, 3> counts = {};
+  for (int i = 0; i < 30000; ++i) ++counts[UniformBelow(3, gen)];
+  for (const int count : counts) {
+    EXPECT_GT(count, 9500);
+    EXPECT_LT(count, 10500);
+  }
+}
+
+TEST(ShuffleTest, Uniform) {
+  Xoshiro256StarStar gen(42);
+  std::map<std::vector<Card>, int> counts;
+  for (int i = 0; i < 60000; ++i) {
+    std::vector<Card> cards = {1, 2, 3, 4};
+    Shuffle(cards, gen);
+    ++counts[cards];
+  }
+  EXPECT_EQ(counts.size(), 24);
+  for (const auto& [cards, count] : counts) {
+    EXPECT_GT(count, 2200);
+    EXPECT_LT(count, 2800);
+  }
+}
+
+}  // namespace
+}  // namespace bataille
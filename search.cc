@@ -0,0 +1,111 @@
+#include "search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace bataille {
+
+std::string_view SearchObjectiveName(SearchObjective objective) {
+  return objective == SearchObjective::kLongest ? "longest" : "shortest_cycle";
+}
+
+std::optional<SearchObjective> ParseSearchObjective(std::string_view name) {
+  if (name == "longest") return SearchObjective::kLongest;
+  if (name == "shortest_cycle") return SearchObjective::kShortestCycle;
+  return std::nullopt;
+}
+
+DealSearch::DealSearch(Deck deck, Strategy strategy, SearchObjective objective,
+                       Xoshiro256StarStar gen)
+    : strategy_(strategy),
+      objective_(objective),
+      gen_(gen),
+      deal_(deck.Make()),
+      candidates_(kNumCandidates * deck.num_cards()),
+      results_(kNumCandidates) {}
+
+double DealSearch::Score(const Game::Result& result) const {
+  const bool cycle = result.winner == Game::Winner::kCycle;
+  if (objective_ == SearchObjective::kLongest) {
+    return cycle ? -1 : result.num_steps;
+  }
+  // Games without cycles are all equally bad: the search walks randomly
+  // until it finds a cycle.
+  return cycle ? -static_cast<double>(result.num_steps)
+               : -std::numeric_limits<double>::infinity();
+}
+
+void DealSearch::Restart(GameArena& arena) {
+  if (best_deal_.empty() || num_climbs_ % kRandomRestartPeriod == 0) {
+    Shuffle(deal_, gen_);
+  } else {
+    deal_ = best_deal_;
+    for (unsigned i = 0; i < kKickSize; ++i) Mutate(deal_);
+  }
+  ++num_climbs_;
+  score_ = Score(arena.Play(deal_, strategy_));
+  climb_score_ = score_;
+  steps_since_better_ = 0;
+}
+
+void DealSearch::Mutate(std::span<Card> cards) {
+  const uint32_t n = cards.size();
+  const uint32_t i = UniformBelow(n, gen_);
+  const uint32_t j = (i + 1 + UniformBelow(n - 1, gen_)) % n;
+  if (gen_() & 1) {
+    std::swap(cards[i], cards[j]);
+  } else {
+    const auto first = cards.begin() + std::min(i, j);
+    const auto last = cards.begin() + std::max(i, j) + 1;
+    if (i < j) {
+      std::rotate(first, first + 1, last);
+    } else {
+      std::rotate(first, last - 1, last);
+    }
+  }
+}
+
+void DealSearch::Run(GameArena& arena, uint64_t num_steps) {
+  const size_t n = deal_.size();
+  if (n < 2) return;
+  if (num_climbs_ == 0) Restart(arena);
+  for (uint64_t step = 0; step < num_steps; ++step) {
+    for (size_t c = 0; c < kNumCandidates; ++c) {
+      const std::span<Card> candidate = std::span(candidates_).subspan(c * n, n);
+      std::copy(deal_.begin(), deal_.end(), candidate.begin());
+      Mutate(candidate);
+    }
+    arena.PlayBatch(candidates_, results_, strategy_);
+    size_t best = 0;
+    double best_candidate_score = Score(results_[0]);
+    for (size_t c = 1; c < kNumCandidates; ++c) {
+      const double score = Score(results_[c]);
+      if (score > best_candidate_score) {
+        best_candidate_score = score;
+        best = c;
+      }
+    }
+    // Moving to equally good deals lets the climb cross plateaus.
+    if (best_candidate_score >= score_) {
+      std::copy_n(candidates_.begin() + best * n, n, deal_.begin());
+      score_ = best_candidate_score;
+    }
+    if (score_ > best_score_) {
+      best_deal_ = deal_;
+      best_score_ = score_;
+    }
+    if (score_ > climb_score_) {
+      climb_score_ = score_;
+      steps_since_better_ = 0;
+    } else if (++steps_since_better_ >= kPatience) {
+      Restart(arena);
+    }
+  }
+}
+
+}  // namespace bataille
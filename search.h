@@ -0,0 +1,82 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "bataille.h"
+#include "rng.h"
+
+namespace bataille {
+
+// What `DealSearch` looks for.
+enum class SearchObjective {
+  kLongest,        // Games that end after as many rounds as possible.
+  kShortestCycle,  // Games that reach a cycle in as few rounds as possible.
+};
+
+// Returns the name of the objective: "longest" or "shortest_cycle".
+std::string_view SearchObjectiveName(SearchObjective objective);
+// Returns the objective named `name`, or std::nullopt if there is none.
+std::optional<SearchObjective> ParseSearchObjective(std::string_view name);
+
+// Searches for record deals with iterated local search. Each step plays a
+// batch of mutations of the current deal (swapping two cards, or rotating the
+// cards between two positions by one), and moves to the best of them unless it
+// is worse. When the climb stops improving, the search starts a new climb from
+// the best deal found so far with a few random mutations, or from time to time
+// from a random deal. Good deals are close to each other: a mutation of a long
+// game is usually a long game.
+//
+// Records are kept in the stats of the arena that plays the games, as in the
+// other modes.
+class DealSearch {
+ public:
+  static constexpr size_t kNumCandidates = 64;
+  // Steps without a better deal before starting a new climb.
+  static constexpr unsigned kPatience = 30;
+  // Mutations of the best deal at the start of a climb.
+  static constexpr unsigned kKickSize = 6;
+  // One climb out of this many starts from a random deal.
+  static constexpr unsigned kRandomRestartPeriod = 10;
+
+  DealSearch(Deck deck, Strategy strategy, SearchObjective objective,
+             Xoshiro256StarStar gen);
+
+  // Does `num_steps` steps, playing games with `arena`.
+  void Run(GameArena& arena, uint64_t num_steps);
+
+  // The best deal found so far.
+  const std::vector<Card>& best_deal() const { return best_deal_; }
+
+ private:
+  // Returns the score of a game, higher is better.
+  double Score(const Game::Result& result) const;
+  // Starts a new climb.
+  void Restart(GameArena& arena);
+  // Applies a random mutation to `cards`.
+  void Mutate(std::span<Card> cards);
+
+  const Strategy strategy_;
+  const SearchObjective objective_;
+  Xoshiro256StarStar gen_;
+  std::vector<Card> deal_;
+  double score_ = 0;
+  // The best score of the current climb.
+  double climb_score_ = 0;
+  unsigned steps_since_better_ = 0;
+  unsigned num_climbs_ = 0;
+  std::vector<Card> best_deal_;
+  double best_score_ = -std::numeric_limits<double>::infinity();
+  std::vector<Card> candidates_;
+  std::vector<Game::Result> results_;
+};
+
+}  // namespace bataille
+
+#endif  // SEARCH_H
@@ -0,0 +1,62 @@
+#include "search.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace bataille {
+namespace {
+
+constexpr Deck kDeck = {.colors = 1, .values = 9};
+
+TEST(SearchTest, Names) {
+  for (const SearchObjective objective :
+       {SearchObjective::kLongest, SearchObjective::kShortestCycle}) {
+    EXPECT_EQ(ParseSearchObjective(SearchObjectiveName(objective)), objective);
+  }
+  EXPECT_EQ(ParseSearchObjective("shortest"), std::nullopt);
+}
+
+TEST(SearchTest, DealsArePermutationsOfTheDeck) {
+  GameArena arena(kDeck);
+  DealSearch search(kDeck, Strategy::kNatural, SearchObjective::kLongest,
+                    Xoshiro256StarStar(42));
+  search.Run(arena, 100);
+  std::vector<Card> cards = search.best_deal();
+  std::sort(cards.begin(), cards.end());
+  EXPECT_EQ(cards, kDeck.Make());
+  EXPECT_GT(arena.stats().num_played, 100 * DealSearch::kNumCandidates);
+}
+
+TEST(SearchTest, Deterministic) {
+  GameArena arena(kDeck);
+  DealSearch a(kDeck, Strategy::kNatural, SearchObjective::kLongest,
+               Xoshiro256StarStar(42));
+  DealSearch b(kDeck, Strategy::kNatural, SearchObjective::kLongest,
+               Xoshiro256StarStar(42));
+  a.Run(arena, 50);
+  b.Run(arena, 20);
+  b.Run(arena, 30);
+  EXPECT_EQ(a.best_deal(), b.best_deal());
+}
+
+// The records of the 1x9 deck, from the exhaustive exploration: the longest
+// game has 28 rounds, the shortest game with a cycle 20.
+TEST(SearchTest, FindsLongest) {
+  GameArena arena(kDeck);
+  DealSearch search(kDeck, Strategy::kNatural, SearchObjective::kLongest,
+                    Xoshiro256StarStar(42));
+  search.Run(arena, 2000);
+  EXPECT_EQ(arena.stats().longest_len, 28);
+}
+
+TEST(SearchTest, FindsShortestCycle) {
+  GameArena arena(kDeck);
+  DealSearch search(kDeck, Strategy::kNatural, SearchObjective::kShortestCycle,
+                    Xoshiro256StarStar(42));
+  search.Run(arena, 2000);
+  EXPECT_EQ(arena.stats().shortest_with_cycle_len, 20);
+}
+
+}  // namespace
+}  // namespace bataille
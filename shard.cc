@@ -0,0 +1,124 @@
+#include "shard.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "checkpoint.h"
+#include "multiset.h"
+
+namespace bataille {
+namespace {
+
+__extension__ typedef unsigned __int128 uint128;
+
+constexpr std::string_view kShardHeader = "bataille-shard 1";
+
+}  // namespace
+
+IndexRange ShardRange(uint64_t num_ranks, unsigned shard, unsigned num_shards) {
+  assert(shard < num_shards);
+  const auto bound = [&](unsigned i) {
+    return static_cast<uint64_t>(static_cast<uint128>(num_ranks) * i /
+                                 num_shards);
+  };
+  return {.begin = bound(shard), .end = bound(shard + 1)};
+}
+
+bool WriteShardResult(const ShardResult& result, const std::string& path) {
+  std::ofstream os(path, std::ios::trunc);
+  os << kShardHeader << "\n";
+  os << "deck " << result.deck.colors << " " << result.deck.values << "\n";
+  os << "strategy " << StrategyName(result.strategy) << "\n";
+  os << "range " << result.range.begin << " " << result.range.end << "\n";
+  os << "elapsed " << result.elapsed.count() << "\n";
+  WriteStats(result.stats, os);
+  os.flush();
+  return static_cast<bool>(os);
+}
+
+std::optional<ShardResult> ReadShardResult(const std::string& path) {
+  std::ifstream is(path);
+  std::string header;
+  if (!std::getline(is, header) || header != kShardHeader) {
+    return std::nullopt;
+  }
+  std::string key;
+  Deck deck;
+  if (!(is >> key) || key != "deck" || !(is >> deck.colors >> deck.values)) {
+    return std::nullopt;
+  }
+  ShardResult result(deck);
+  std::string strategy;
+  if (!(is >> key) || key != "strategy" || !(is >> strategy)) {
+    return std::nullopt;
+  }
+  const std::optional<Strategy> parsed_strategy = ParseStrategy(strategy);
+  if (!parsed_strategy) return std::nullopt;
+  result.strategy = *parsed_strategy;
+  long long elapsed = 0;
+  if (!(is >> key) || key != "range" ||
+      !(is >> result.range.begin >> result.range.end) || !(is >> key) ||
+      key != "elapsed" || !(is >> elapsed) || !ReadStats(is, result.stats)) {
+    return std::nullopt;
+  }
+  result.elapsed = std::chrono::seconds(elapsed);
+  return result;
+}
+
+std::optional<ShardResult> MergeShards(const std::vector<ShardResult>& shards,
+                                       std::string& error) {
+  if (shards.empty()) {
+    error = "no shards";
+    return std::nullopt;
+  }
+  const Deck deck = shards[0].deck;
+  const Strategy strategy = shards[0].strategy;
+  std::vector<const ShardResult*> sorted;
+  for (const ShardResult& shard : shards) {
+    if (shard.deck.colors != deck.colors || shard.deck.values != deck.values ||
+        shard.strategy != strategy) {
+      error = "shards are for different explorations";
+      return std::nullopt;
+    }
+    sorted.push_back(&shard);
+  }
+  // Merging in rank order keeps the same records as a single exploration.
+  std::sort(sorted.begin(), sorted.end(),
+            [](const ShardResult* a, const ShardResult* b) {
+              return a->range.begin < b->range.begin;
+            });
+
+  const uint64_t num_ranks = NumPermutations(deck.Make());
+  ShardResult merged(deck);
+  merged.strategy = strategy;
+  merged.range = {.begin = 0, .end = 0};
+  for (const ShardResult* shard : sorted) {
+    if (shard->range.begin > merged.range.end) {
+      error = "ranks [" + std::to_string(merged.range.end) + ", " +
+              std::to_string(shard->range.begin) + ") are not covered";
+      return std::nullopt;
+    }
+    if (shard->range.begin < merged.range.end) {
+      error = "ranks [" + std::to_string(shard->range.begin) + ", " +
+              std::to_string(std::min(merged.range.end, shard->range.end)) +
+              ") are covered more than once";
+      return std::nullopt;
+    }
+    merged.range.end = shard->range.end;
+    merged.elapsed += shard->elapsed;
+    merged.stats.Merge(shard->stats);
+  }
+  if (merged.range.end != num_ranks) {
+    error = "ranks [" + std::to_string(merged.range.end) + ", " +
+            std::to_string(num_ranks) + ") are not covered";
+    return std::nullopt;
+  }
+  return merged;
+}
+
+}  // namespace bataille
@@ -0,0 +1,50 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bataille.h"
+#include "work_stealing.h"
+
+namespace bataille {
+
+// An exhaustive exploration can be split into shards that play disjoint
+// ranges of deal ranks (see `Rank`), for example on different machines. The
+// results of the shards are then merged.
+
+// Returns the `shard`-th (from 0) of `num_shards` ranges of equal size (up to
+// rounding) that partition [0, num_ranks).
+IndexRange ShardRange(uint64_t num_ranks, unsigned shard, unsigned num_shards);
+
+// The result of an exhaustive exploration of the deals whose rank is in
+// `range`.
+struct ShardResult {
+  explicit ShardResult(Deck d) : deck(d), stats(d) {}
+
+  Deck deck;
+  Strategy strategy = Strategy::kNatural;
+  IndexRange range = {.begin = 0, .end = 0};
+  std::chrono::seconds elapsed{0};
+  GameArena::Stats stats;
+};
+
+// Writes `result` to `path`, as text. Returns false on error.
+bool WriteShardResult(const ShardResult& result, const std::string& path);
+
+// Returns std::nullopt if the file cannot be read.
+std::optional<ShardResult> ReadShardResult(const std::string& path);
+
+// Merges the results of shards of an exhaustive exploration. The shards must
+// have the same deck and strategy, and their ranges must cover all deal ranks
+// exactly once. Otherwise, returns std::nullopt and sets `error`. The elapsed
+// time of the merged result is the sum of the times of the shards.
+std::optional<ShardResult> MergeShards(const std::vector<ShardResult>& shards,
+                                       std::string& error);
+
+}  // namespace bataille
+
+#endif  // SHARD_H
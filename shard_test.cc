@@ -0,0 +1,118 @@
+#include "shard.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "multiset.h"
+
+namespace bataille {
+namespace {
+
+TEST(ShardTest, RangesPartition) {
+  for (const uint64_t num_ranks : {0, 1, 7, 100, 12345}) {
+    for (const unsigned num_shards : {1, 2, 3, 8, 13}) {
+      uint64_t end = 0;
+      for (unsigned shard = 0; shard < num_shards; ++shard) {
+        const IndexRange range = ShardRange(num_ranks, shard, num_shards);
+        EXPECT_EQ(range.begin, end);
+        EXPECT_LE(range.size(), num_ranks / num_shards + 1);
+        end = range.end;
+      }
+      EXPECT_EQ(end, num_ranks);
+    }
+  }
+}
+
+TEST(ShardTest, HugeRanges) {
+  const uint64_t num_ranks = ~uint64_t{0};
+  EXPECT_EQ(ShardRange(num_ranks, 2, 3).end, num_ranks);
+  EXPECT_EQ(ShardRange(num_ranks, 1, 2).begin, num_ranks / 2);
+}
+
+// Plays the deals in `range`, like an exhaustive exploration.
+ShardResult PlayShard(Deck deck, IndexRange range) {
+  ShardResult result(deck);
+  result.range = range;
+  GameArena arena(deck);
+  std::vector<Card> cards = deck.Make();
+  if (!range.empty()) Unrank(range.begin, cards);
+  for (uint64_t rank = range.begin; rank < range.end; ++rank) {
+    arena.Play(cards, Strategy::kNatural);
+    std::next_permutation(cards.begin(), cards.end());
+  }
+  result.stats.Merge(arena.stats());
+  return result;
+}
+
+TEST(ShardTest, MergeIsSameAsSingleRun) {
+  const Deck deck = {.colors = 2, .values = 4};
+  const uint64_t num_ranks = NumPermutations(deck.Make());
+  const ShardResult full = PlayShard(deck, {.begin = 0, .end = num_ranks});
+
+  // Order does not matter.
+  std::vector<ShardResult> shards;
+  for (const unsigned shard : {3, 1, 4, 0, 2}) {
+    shards.push_back(PlayShard(deck, ShardRange(num_ranks, shard, 5)));
+  }
+  std::string error;
+  const auto merged = MergeShards(shards, error);
+  ASSERT_TRUE(merged) << error;
+  EXPECT_EQ(merged->stats.num_played, full.stats.num_played);
+  EXPECT_EQ(merged->stats.num_played_with_cycle,
+            full.stats.num_played_with_cycle);
+  EXPECT_EQ(merged->stats.longest_len, full.stats.longest_len);
+  EXPECT_EQ(merged->stats.longest, full.stats.longest);
+  EXPECT_EQ(merged->stats.shortest_with_cycle_len,
+            full.stats.shortest_with_cycle_len);
+  EXPECT_EQ(merged->stats.shortest_with_cycle, full.stats.shortest_with_cycle);
+}
+
+TEST(ShardTest, MergeChecksCoverage) {
+  const Deck deck = {.colors = 2, .values = 3};  // 90 ranks.
+  const auto shard = [&](uint64_t begin, uint64_t end) {
+    ShardResult result(deck);
+    result.range = {.begin = begin, .end = end};
+    return result;
+  };
+  std::string error;
+  EXPECT_TRUE(MergeShards({shard(0, 40), shard(40, 90)}, error));
+  EXPECT_FALSE(MergeShards({shard(0, 40), shard(50, 90)}, error));
+  EXPECT_EQ(error, "ranks [40, 50) are not covered");
+  EXPECT_FALSE(MergeShards({shard(0, 40), shard(30, 90)}, error));
+  EXPECT_EQ(error, "ranks [30, 40) are covered more than once");
+  EXPECT_FALSE(MergeShards({shard(0, 40)}, error));
+  EXPECT_EQ(error, "ranks [40, 90) are not covered");
+  EXPECT_FALSE(MergeShards({}, error));
+
+  ShardResult other_deck({.colors = 3, .values = 2});
+  other_deck.range = {.begin = 40, .end = 90};
+  EXPECT_FALSE(MergeShards({shard(0, 40), other_deck}, error));
+}
+
+TEST(ShardTest, WriteAndRead) {
+  const Deck deck = {.colors = 2, .values = 4};
+  ShardResult result = PlayShard(deck, {.begin = 100, .end = 2000});
+  result.strategy = Strategy::kOptimized;
+  result.elapsed = std::chrono::seconds(12);
+  const std::string path = testing::TempDir() + "/shard_test.shard";
+  ASSERT_TRUE(WriteShardResult(result, path));
+  const auto read = ReadShardResult(path);
+  std::remove(path.c_str());
+  ASSERT_TRUE(read);
+  EXPECT_EQ(read->deck.colors, 2);
+  EXPECT_EQ(read->deck.values, 4);
+  EXPECT_EQ(read->strategy, Strategy::kOptimized);
+  EXPECT_EQ(read->range.begin, 100);
+  EXPECT_EQ(read->range.end, 2000);
+  EXPECT_EQ(read->elapsed, std::chrono::seconds(12));
+  EXPECT_EQ(read->stats.num_played, result.stats.num_played);
+  EXPECT_EQ(read->stats.longest, result.stats.longest);
+}
+
+}  // namespace
+}  // namespace bataille
@@ -0,0 +1,176 @@
+#include "state_graph.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "multiset.h"
+
+namespace bataille {
+namespace {
+
+// Outcomes of states. Solved outcomes have the winner, the number of rounds
+// until the end of the game (for cycles, until the cycle, i.e. `mu`), and
+// `lambda` for cycles. While a path is followed, its states are marked with
+// their position in the path.
+constexpr uint64_t kUnvisited = 0;
+constexpr uint64_t kOnPath = uint64_t{1} << 63;
+constexpr uint64_t kSolved = uint64_t{1} << 62;
+constexpr unsigned kWinnerShift = 60;
+constexpr unsigned kLambdaShift = 30;
+constexpr uint64_t kFieldMask = (uint64_t{1} << 30) - 1;
+
+uint64_t Solved(Game::Winner winner, uint64_t lambda) {
+  assert(lambda <= kFieldMask);
+  return kSolved | static_cast<uint64_t>(winner) << kWinnerShift |
+         lambda << kLambdaShift;
+}
+
+class StateGraphEngine : public Engine {
+ public:
+  explicit StateGraphEngine(const StateGraph& graph) : graph_(graph) {}
+
+  Game::Result Play(std::span<const Card> cards, Strategy strategy) override {
+    assert(strategy == graph_.strategy());
+    (void)strategy;
+    return graph_.Play(cards);
+  }
+
+  // Lookups in the graph are faster than in the cache.
+  void SetCache(OutcomeCache*, GameArena::Stats::CacheCounters*) override {}
+
+ private:
+  const StateGraph& graph_;
+};
+
+}  // namespace
+
+uint64_t StateGraph::NumStates(Deck deck) {
+  const uint64_t num_permutations = NumPermutations(deck.Make());
+  const uint64_t num_splits = deck.num_cards() < 2 ? 0 : deck.num_cards() - 1;
+  if (num_splits > 0 &&
+      num_permutations > std::numeric_limits<uint64_t>::max() / num_splits) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return num_splits * num_permutations;
+}
+
+StateGraph::StateGraph(Deck deck, Strategy strategy)
+    : deck_(deck),
+      strategy_(strategy),
+      num_permutations_(NumPermutations(deck.Make())),
+      outcomes_(NumStates(deck), kUnvisited) {
+  assert(deck.num_cards() >= 2);
+  assert(outcomes_.size() <= kMaxStates);
+  assert(deck.values <= kMaxValues);
+  Game game(deck);
+  std::vector<uint64_t> path;
+  // Paths start from the deals only: other states are solved if a deal
+  // reaches them, and are never looked up otherwise.
+  const unsigned num_left = deck.num_cards() / 2;
+  const uint64_t first_deal = (num_left - 1) * num_permutations_;
+  // The cards of `state`, in lexicographic order.
+  std::vector<Card> state_cards = deck.Make();
+  for (uint64_t state = first_deal; state < first_deal + num_permutations_;
+       ++state, std::next_permutation(state_cards.begin(), state_cards.end())) {
+    if (outcomes_[state] != kUnvisited) continue;
+    game.Deal(state_cards, num_left);
+
+    // Follows the path from `state` until the outcome after its last state is
+    // known.
+    path.clear();
+    uint64_t current = state;
+    uint64_t outcome;
+    while (true) {
+      outcomes_[current] = kOnPath | path.size();
+      path.push_back(current);
+      ++num_solved_;
+      if (game.Step(strategy)) {
+        outcome = Solved(game.GetWinner(), 0);
+        break;
+      }
+      const uint64_t next = RankState(game);
+      const uint64_t next_outcome = outcomes_[next];
+      if (next_outcome == kUnvisited) {
+        current = next;
+        continue;
+      }
+      if (next_outcome & kOnPath) {
+        // The states of the path from `next` are a cycle.
+        const size_t start = next_outcome & ~kOnPath;
+        outcome = Solved(Game::Winner::kCycle, path.size() - start);
+        for (size_t i = start; i < path.size(); ++i) {
+          outcomes_[path[i]] = outcome;
+        }
+        path.resize(start);
+        break;
+      }
+      outcome = next_outcome;
+      break;
+    }
+    // Each state is one round further from the outcome than the next one.
+    for (size_t i = path.size(); i-- > 0;) {
+      ++outcome;
+      assert((outcome & kFieldMask) != 0);
+      outcomes_[path[i]] = outcome;
+    }
+  }
+}
+
+uint64_t StateGraph::RankCards(std::span<const Card> cards) const {
+  // Cards are 1 to `values`, with `colors` cards of each value.
+  std::array<unsigned, kMaxValues + 1> counts;
+  counts.fill(deck_.colors);
+  // `num_perms` is the number of permutations of the remaining cards. Since
+  // there are few permutations, `num_perms * m` fits in 64 bits.
+  uint64_t num_perms = num_permutations_;
+  uint64_t rank = 0;
+  unsigned m = cards.size();
+  for (const Card card : cards) {
+    assert(card >= 1 && card <= deck_.values);
+    // All permutations starting with a smaller card come first.
+    unsigned num_smaller = 0;
+    for (unsigned v = 1; v < card; ++v) num_smaller += counts[v];
+    rank += num_perms * num_smaller / m;
+    num_perms = num_perms * counts[card] / m;
+    --counts[card];
+    --m;
+  }
+  return rank;
+}
+
+uint64_t StateGraph::RankState(const Game& game) {
+  cards_.clear();
+  game.left().AppendTo(cards_);
+  game.right().AppendTo(cards_);
+  return (game.left().size() - 1) * num_permutations_ + RankCards(cards_);
+}
+
+Game::Result StateGraph::Play(std::span<const Card> cards) const {
+  assert(cards.size() == deck_.num_cards());
+  const uint64_t outcome =
+      outcomes_[(cards.size() / 2 - 1) * num_permutations_ + RankCards(cards)];
+  const auto winner =
+      static_cast<Game::Winner>((outcome >> kWinnerShift) & 3);
+  const unsigned num_steps = outcome & kFieldMask;
+  if (winner != Game::Winner::kCycle) {
+    return {.winner = winner, .num_steps = num_steps};
+  }
+  // See `Game::Result` for the length of games with a cycle.
+  const unsigned lambda = (outcome >> kLambdaShift) & kFieldMask;
+  return {.winner = winner,
+          .num_steps = (num_steps / lambda + 1) * lambda,
+          .mu = num_steps,
+          .lambda = lambda};
+}
+
+std::unique_ptr<Engine> MakeStateGraphEngine(const StateGraph& graph) {
+  return std::make_unique<StateGraphEngine>(graph);
+}
+
+}  // namespace bataille
@@ -0,0 +1,78 @@
+#ifndef STATE_GRAPH_H
+#define STATE_GRAPH_H
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "bataille.h"
+#include "engine.h"
+
+namespace bataille {
+
+// The results of the games of every state of a small deck, for one strategy.
+//
+// A state is a permutation of the deck with the first `k` cards in the left
+// hand and the others in the right hand, for 0 < k < num_cards, ranked as
+// `(k - 1) * NumPermutations(deck) + Rank(cards)`. A round maps each state to
+// another state or ends the game, so the states form a functional graph.
+// Paths are followed from each deal until they reach a solved state, the end
+// of a game, or a state of the path (a cycle), and the states of the path are
+// solved backwards, so that each state reached from a deal is stepped once.
+// Deals are then solved by a lookup.
+//
+// This is not faster than playing the deals: states are ranked and looked up
+// at each round, in a table `2 * (num_cards - 1)` times larger than the number
+// of canonical deals. It gives the same results without detecting cycles, and
+// serves as a cross-check of the engines.
+class StateGraph {
+ public:
+  // Outcomes take 8 bytes per state, so a graph takes at most 128 MiB. This
+  // allows `C=1` up to `V=9`, `C=2` up to `V=5` and `C=3` up to `V=4`.
+  static constexpr uint64_t kMaxStates = uint64_t{1} << 24;
+  // Decks with more values have too many states.
+  static constexpr unsigned kMaxValues = 9;
+
+  // Returns the number of states of `deck`, or
+  // `std::numeric_limits<uint64_t>::max()` if that does not fit in 64 bits.
+  static uint64_t NumStates(Deck deck);
+
+  // Solves the states of `deck`. Precondition:
+  // 2 <= deck.num_cards() and NumStates(deck) <= kMaxStates.
+  StateGraph(Deck deck, Strategy strategy);
+
+  Deck deck() const { return deck_; }
+  Strategy strategy() const { return strategy_; }
+  uint64_t num_states() const { return outcomes_.size(); }
+  // The number of states reached from a deal, which are solved.
+  uint64_t num_solved() const { return num_solved_; }
+
+  // The result of the game dealt with `cards` (as in `Game::Deal`), the same
+  // as `GameArena::Play`.
+  Game::Result Play(std::span<const Card> cards) const;
+
+ private:
+  // Same as `Rank(cards)` for the permutations of the deck, but faster: there
+  // are few permutations, and the cards are known.
+  uint64_t RankCards(std::span<const Card> cards) const;
+  // Returns the rank of the state of `game`, whose cards are in `cards_`.
+  uint64_t RankState(const Game& game);
+
+  const Deck deck_;
+  const Strategy strategy_;
+  const uint64_t num_permutations_;
+  // See `state_graph.cc` for the encoding.
+  std::vector<uint64_t> outcomes_;
+  uint64_t num_solved_ = 0;
+  // Scratch space.
+  std::vector<Card> cards_;
+};
+
+// Returns an engine that looks up the results of its games in `graph`, which
+// must outlive it. It can only play `graph.strategy()`.
+std::unique_ptr<Engine> MakeStateGraphEngine(const StateGraph& graph);
+
+}  // namespace bataille
+
+#endif  // STATE_GRAPH_H
@@ -0,0 +1,100 @@
+#include "state_graph.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+TEST(StateGraphTest, NumStates) {
+  EXPECT_EQ(StateGraph::NumStates(Deck::Seq(1)), 0);
+  EXPECT_EQ(StateGraph::NumStates(Deck::Seq(3)), 2 * 6);
+  EXPECT_EQ(StateGraph::NumStates({.colors = 2, .values = 2}), 3 * 6);
+  EXPECT_LE(StateGraph::NumStates(Deck::Seq(9)), StateGraph::kMaxStates);
+  EXPECT_GT(StateGraph::NumStates(Deck::Seq(10)), StateGraph::kMaxStates);
+  EXPECT_LE(StateGraph::NumStates({.colors = 2, .values = 5}),
+            StateGraph::kMaxStates);
+  EXPECT_GT(StateGraph::NumStates({.colors = 2, .values = 6}),
+            StateGraph::kMaxStates);
+  EXPECT_LE(StateGraph::NumStates({.colors = 3, .values = 4}),
+            StateGraph::kMaxStates);
+  EXPECT_EQ(StateGraph::NumStates(Deck::Standard54()),
+            std::numeric_limits<uint64_t>::max());
+}
+
+TEST(StateGraphTest, SolvesStatesReachedFromDeals) {
+  const StateGraph graph(Deck::Seq(7), Strategy::kNatural);
+  EXPECT_GE(graph.num_solved(), 5040);
+  EXPECT_LT(graph.num_solved(), graph.num_states());
+}
+
+// Checks that the graph gives the same results as `GameArena` for every deal.
+void ExpectSameAsArena(Deck deck, Strategy strategy) {
+  const StateGraph graph(deck, strategy);
+  GameArena arena(deck);
+  std::vector<Card> cards = deck.Make();
+  do {
+    const Game::Result expected = arena.Play(cards, strategy);
+    const Game::Result result = graph.Play(cards);
+    ASSERT_EQ(result.winner, expected.winner);
+    ASSERT_EQ(result.num_steps, expected.num_steps);
+    ASSERT_EQ(result.mu, expected.mu);
+    ASSERT_EQ(result.lambda, expected.lambda);
+  } while (std::next_permutation(cards.begin(), cards.end()));
+}
+
+TEST(StateGraphTest, SameAsArena) {
+  for (const Strategy strategy : {Strategy::kNatural, Strategy::kOptimized}) {
+    ExpectSameAsArena(Deck::Seq(2), strategy);
+    ExpectSameAsArena(Deck::Seq(7), strategy);
+    ExpectSameAsArena({.colors = 2, .values = 1}, strategy);
+    ExpectSameAsArena({.colors = 2, .values = 4}, strategy);
+    ExpectSameAsArena({.colors = 4, .values = 2}, strategy);
+    ExpectSameAsArena({.colors = 3, .values = 3}, strategy);
+  }
+}
+
+// Returns the stats of an exhaustive exploration with `graph`.
+GameArena::Stats Explore(const StateGraph& graph) {
+  GameArena arena(graph.deck());
+  arena.SetEngine(MakeStateGraphEngine(graph));
+  std::vector<Card> cards = graph.deck().Make();
+  std::vector<Game::Result> results(1);
+  do {
+    arena.PlayBatch(cards, results, graph.strategy());
+  } while (std::next_permutation(cards.begin(), cards.end()));
+  return arena.stats();
+}
+
+TEST(StateGraphTest, SameAsResults) {
+  // As in results/c1v*.txt.
+  const GameArena::Stats c1v5 =
+      Explore(StateGraph(Deck::Seq(5), Strategy::kNatural));
+  EXPECT_EQ(c1v5.num_played_with_cycle, 30);
+  EXPECT_EQ(c1v5.shortest_with_cycle_len, 6);
+  EXPECT_EQ(c1v5.longest_len, 8);
+
+  const GameArena::Stats c1v7 =
+      Explore(StateGraph(Deck::Seq(7), Strategy::kNatural));
+  EXPECT_EQ(c1v7.num_played_with_cycle, 2304);
+  EXPECT_EQ(c1v7.shortest_with_cycle_len, 8);
+  EXPECT_EQ(c1v7.longest_len, 15);
+
+  const GameArena::Stats c1v9 =
+      Explore(StateGraph(Deck::Seq(9), Strategy::kNatural));
+  EXPECT_EQ(c1v9.num_played, 362880);
+  EXPECT_EQ(c1v9.num_played_with_cycle, 218680);
+  EXPECT_EQ(c1v9.shortest_with_cycle_len, 20);
+  EXPECT_EQ(c1v9.longest_len, 28);
+  // The first records in lexicographic order.
+  Game longest(Deck::Seq(9));
+  longest.Deal(std::vector<Card>{1, 2, 3, 8, 6, 5, 4, 7, 9});
+  EXPECT_EQ(c1v9.longest, longest);
+}
+
+}  // namespace
+}  // namespace bataille
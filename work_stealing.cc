@@ -0,0 +1,111 @@
+#include "work_stealing.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace bataille {
+
+WorkStealingRanges::WorkStealingRanges(IndexRange range, unsigned num_workers,
+                                       uint64_t chunk_size)
+    : num_workers_(num_workers),
+      chunk_size_(chunk_size),
+      shares_(std::make_unique<Share[]>(num_workers)) {
+  assert(num_workers > 0);
+  assert(chunk_size > 0);
+  for (unsigned i = 0; i < num_workers; ++i) {
+    const IndexRange share = {
+        .begin = range.begin + range.size() * i / num_workers,
+        .end = range.begin + range.size() * (i + 1) / num_workers};
+    if (!share.empty()) shares_[i].ranges.push_back(share);
+  }
+}
+
+WorkStealingRanges::WorkStealingRanges(const std::vector<IndexRange>& ranges,
+                                       unsigned num_workers,
+                                       uint64_t chunk_size)
+    : num_workers_(num_workers),
+      chunk_size_(chunk_size),
+      shares_(std::make_unique<Share[]>(num_workers)) {
+  assert(num_workers > 0);
+  assert(chunk_size > 0);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (!ranges[i].empty()) {
+      shares_[i % num_workers].ranges.push_back(ranges[i]);
+    }
+  }
+}
+
+std::optional<IndexRange> WorkStealingRanges::Next(unsigned worker) {
+  assert(worker < num_workers_);
+  Share& share = shares_[worker];
+  do {
+    std::lock_guard<std::mutex> lock(share.mu);
+    if (!share.ranges.empty()) {
+      IndexRange& front = share.ranges.front();
+      const IndexRange chunk = {
+          .begin = front.begin,
+          .end = front.begin + std::min(chunk_size_, front.size())};
+      front.begin = chunk.end;
+      if (front.empty()) share.ranges.erase(share.ranges.begin());
+      return chunk;
+    }
+  } while (Steal(worker));
+  return std::nullopt;
+}
+
+bool WorkStealingRanges::Steal(unsigned thief) {
+  while (true) {
+    // Find the victim with the largest last range. This is racy, but we
+    // re-check under the lock below.
+    unsigned victim = num_workers_;
+    uint64_t victim_size = 0;
+    for (unsigned i = 0; i < num_workers_; ++i) {
+      if (i == thief) continue;
+      std::lock_guard<std::mutex> lock(shares_[i].mu);
+      if (!shares_[i].ranges.empty() &&
+          shares_[i].ranges.back().size() > victim_size) {
+        victim = i;
+        victim_size = shares_[i].ranges.back().size();
+      }
+    }
+    if (victim == num_workers_) return false;
+
+    IndexRange stolen;
+    {
+      std::lock_guard<std::mutex> lock(shares_[victim].mu);
+      if (shares_[victim].ranges.empty()) continue;  // Someone was faster.
+      IndexRange& back = shares_[victim].ranges.back();
+      if (back.size() <= chunk_size_) {
+        stolen = back;
+        shares_[victim].ranges.pop_back();
+      } else {
+        const uint64_t middle = back.begin + back.size() / 2;
+        stolen = {.begin = middle, .end = back.end};
+        back.end = middle;
+      }
+    }
+    std::lock_guard<std::mutex> lock(shares_[thief].mu);
+    shares_[thief].ranges.push_back(stolen);
+    return true;
+  }
+}
+
+std::vector<IndexRange> WorkStealingRanges::Remaining() const {
+  std::vector<IndexRange> result;
+  for (unsigned i = 0; i < num_workers_; ++i) {
+    std::lock_guard<std::mutex> lock(shares_[i].mu);
+    result.insert(result.end(), shares_[i].ranges.begin(),
+                  shares_[i].ranges.end());
+  }
+  std::sort(result.begin(), result.end(),
+            [](const IndexRange& a, const IndexRange& b) {
+              return a.begin < b.begin;
+            });
+  return result;
+}
+
+}  // namespace bataille
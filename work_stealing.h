@@ -0,0 +1,62 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace bataille {
+
+// A half-open range of integers [begin, end).
+struct IndexRange {
+  uint64_t begin;
+  uint64_t end;
+
+  uint64_t size() const { return end - begin; }
+  bool empty() const { return begin == end; }
+};
+
+// Distributes a range of indices among `num_workers` workers. Each worker
+// initially owns an equal share of the range and consumes it front to back in
+// chunks of at most `chunk_size`. A worker that runs out of work steals the
+// back half of the largest remaining share.
+// This is thread-safe: each worker calls `Next` with its own index.
+class WorkStealingRanges {
+ public:
+  WorkStealingRanges(IndexRange range, unsigned num_workers,
+                     uint64_t chunk_size);
+
+  // Same as above, but the work starts as a list of ranges, which are
+  // distributed round-robin among workers.
+  WorkStealingRanges(const std::vector<IndexRange>& ranges,
+                     unsigned num_workers, uint64_t chunk_size);
+
+  // Returns the next chunk for `worker`, or `std::nullopt` if there is no
+  // work left.
+  std::optional<IndexRange> Next(unsigned worker);
+
+  // Returns the work that has not been handed out yet.
+  std::vector<IndexRange> Remaining() const;
+
+ private:
+  // Remaining work of a worker. Owners take from the front, thieves from the
+  // back.
+  struct alignas(64) Share {
+    mutable std::mutex mu;
+    std::vector<IndexRange> ranges;
+  };
+
+  // Moves work from another worker to `thief`. Returns false if there is no
+  // work left anywhere.
+  bool Steal(unsigned thief);
+
+  const unsigned num_workers_;
+  const uint64_t chunk_size_;
+  const std::unique_ptr<Share[]> shares_;
+};
+
+}  // namespace bataille
+
+#endif  // WORK_STEALING_H
@@ -0,0 +1,77 @@
+#include "work_stealing.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace bataille {
+namespace {
+
+// Consumes all chunks with `num_workers` threads and checks that every index
+// was handed out exactly once.
+void ExpectCoversExactlyOnce(WorkStealingRanges& ranges, unsigned num_workers,
+                             IndexRange range) {
+  std::vector<std::vector<IndexRange>> chunks(num_workers);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < num_workers; ++i) {
+    threads.emplace_back([&, i] {
+      while (const auto chunk = ranges.Next(i)) chunks[i].push_back(*chunk);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  std::vector<int> seen(range.size());
+  for (const auto& worker_chunks : chunks) {
+    for (const IndexRange& chunk : worker_chunks) {
+      for (uint64_t i = chunk.begin; i < chunk.end; ++i) {
+        ++seen[i - range.begin];
+      }
+    }
+  }
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), range.size());
+  EXPECT_TRUE(ranges.Remaining().empty());
+}
+
+TEST(WorkStealingRangesTest, SingleWorker) {
+  WorkStealingRanges ranges({.begin = 3, .end = 10}, 1, 4);
+  auto chunk = ranges.Next(0);
+  ASSERT_TRUE(chunk);
+  EXPECT_EQ(chunk->begin, 3);
+  EXPECT_EQ(chunk->end, 7);
+  ASSERT_EQ(ranges.Remaining().size(), 1);
+  EXPECT_EQ(ranges.Remaining()[0].begin, 7);
+  chunk = ranges.Next(0);
+  ASSERT_TRUE(chunk);
+  EXPECT_EQ(chunk->begin, 7);
+  EXPECT_EQ(chunk->end, 10);
+  EXPECT_FALSE(ranges.Next(0));
+}
+
+TEST(WorkStealingRangesTest, Steals) {
+  WorkStealingRanges ranges({.begin = 0, .end = 100}, 2, 10);
+  // Worker 1 consumes everything, including the share of worker 0.
+  uint64_t total = 0;
+  while (const auto chunk = ranges.Next(1)) total += chunk->size();
+  EXPECT_EQ(total, 100);
+  EXPECT_FALSE(ranges.Next(0));
+}
+
+TEST(WorkStealingRangesTest, ManyWorkers) {
+  const IndexRange range = {.begin = 1000, .end = 101000};
+  WorkStealingRanges ranges(range, 7, 13);
+  ExpectCoversExactlyOnce(ranges, 7, range);
+}
+
+TEST(WorkStealingRangesTest, FromRanges) {
+  WorkStealingRanges ranges(
+      std::vector<IndexRange>{{.begin = 0, .end = 500},
+                              {.begin = 500, .end = 520},
+                              {.begin = 520, .end = 10000}},
+      3, 7);
+  ExpectCoversExactlyOnce(ranges, 3, {.begin = 0, .end = 10000});
+}
+
+}  // namespace
+}  // namespace bataille